@@ -0,0 +1,384 @@
+#!/usr/bin/env python3
+"""Local multi-node cluster harness for performance and failover testing.
+
+Starts several eloqdb processes on localhost (see eloqdb_cluster.py), runs
+a key-value workload against them, injects faults on a schedule and
+reports throughput over time, latency percentiles and recovery times.
+
+Fault specs (--inject, repeatable), times in seconds from workload start:
+  kill:node=1,at=10,restart=5     SIGKILL node 1, restart it 5s later
+  stop:node=1,at=10,restart=5     same with SIGTERM (clean shutdown)
+  pause:node=2,at=20,duration=3   SIGSTOP node 2 for 3s
+  delay:at=30,duration=10,ms=50   netem delay on loopback (needs root)
+
+Instead of the built-in workload, --workload-cmd runs an external load
+generator; "{kv_endpoints}" and "{sql_endpoints}" in it are replaced by
+comma-separated host:port lists. It must print a JSON report in
+eloqdb_bench's layout on its last stdout line: its "metrics" become the
+report's metrics, and its per-second "timeline" (assumed to start
+"warmup_s" after launch) drives the throughput recovery times. Without a
+closed-loop timeline only node recovery times are reported. The harness
+fails if the command exits non-zero or its last line is not a JSON
+object. For example (load the data beforehand so measurement starts
+right after warmup):
+  --workload-cmd "eloqdb_bench --kv_endpoints={kv_endpoints}
+                  --sql_endpoints={sql_endpoints} --duration=60"
+"""
+
+import argparse
+import bisect
+import json
+import math
+import random
+import shlex
+import signal
+import subprocess
+import sys
+import threading
+import time
+
+import eloqdb_cluster
+
+
+class Histogram:
+    """Log-bucketed latency histogram in microseconds (~2% resolution)."""
+
+    def __init__(self):
+        self.bounds = []
+        bound = 1.0
+        while bound < 60e6:
+            self.bounds.append(bound)
+            bound *= 1.02
+        self.counts = [0] * (len(self.bounds) + 1)
+        self.total = 0
+
+    def record(self, value_us):
+        self.counts[bisect.bisect_left(self.bounds, value_us)] += 1
+        self.total += 1
+
+    def merge(self, other):
+        for i, count in enumerate(other.counts):
+            self.counts[i] += count
+        self.total += other.total
+
+    def percentile(self, pct):
+        if not self.total:
+            return 0.0
+        target = math.ceil(self.total * pct / 100.0)
+        seen = 0
+        for i, count in enumerate(self.counts):
+            seen += count
+            if seen >= target:
+                return self.bounds[min(i, len(self.bounds) - 1)]
+        return self.bounds[-1]
+
+
+class KvWorker(threading.Thread):
+    """Closed-loop GET/SET client bound to one node."""
+
+    def __init__(self, harness, node, seed):
+        super().__init__(daemon=True)
+        self.harness = harness
+        self.node = node
+        self.rand = random.Random(seed)
+        self.hist = Histogram()
+        self.errors = 0
+        self.conn = None
+
+    def run(self):
+        h = self.harness
+        value = b"x" * h.args.value_size
+        while not h.stop_event.is_set():
+            try:
+                if self.conn is None:
+                    self.conn = eloqdb_cluster.RespConnection(
+                        self.node.host, self.node.kv_port, timeout=2.0)
+                key = b"key:%d" % self.rand.randrange(h.args.keys)
+                start = time.monotonic()
+                if self.rand.random() < h.args.read_ratio:
+                    self.conn.call(b"GET", key)
+                else:
+                    self.conn.call(b"SET", key, value)
+                end = time.monotonic()
+                self.hist.record((end - start) * 1e6)
+                h.count_op(end)
+            except (OSError, ConnectionError, RuntimeError, ValueError):
+                self.errors += 1
+                if self.conn is not None:
+                    self.conn.close()
+                    self.conn = None
+                time.sleep(0.05)
+        if self.conn is not None:
+            self.conn.close()
+
+
+def parse_fault(spec):
+    kind, _, rest = spec.partition(":")
+    fault = {"kind": kind}
+    for item in filter(None, rest.split(",")):
+        key, _, value = item.partition("=")
+        fault[key] = float(value) if key != "node" else int(value)
+    if kind not in ("kill", "stop", "pause", "delay"):
+        raise argparse.ArgumentTypeError("unknown fault kind %r" % kind)
+    if "at" not in fault:
+        raise argparse.ArgumentTypeError("fault %r needs at=<seconds>" % spec)
+    if kind != "delay" and "node" not in fault:
+        raise argparse.ArgumentTypeError("fault %r needs node=<index>" % spec)
+    return fault
+
+
+class Harness:
+    def __init__(self, args, cluster):
+        self.args = args
+        self.cluster = cluster
+        self.stop_event = threading.Event()
+        self.lock = threading.Lock()
+        self.start_time = None
+        self.per_second = [0] * (int(args.duration) + 1)
+        self.fault_log = []
+
+    def count_op(self, now):
+        second = int(now - self.start_time)
+        if second < len(self.per_second):
+            with self.lock:
+                self.per_second[second] += 1
+
+    def elapsed(self):
+        return time.monotonic() - self.start_time
+
+    def sleep_until(self, at):
+        delay = at - self.elapsed()
+        if delay > 0:
+            self.stop_event.wait(delay)
+
+    def run_fault(self, fault):
+        self.sleep_until(fault["at"])
+        if self.stop_event.is_set():
+            return
+        record = dict(fault, started=self.elapsed())
+        kind = fault["kind"]
+        if kind in ("kill", "stop"):
+            node = self.cluster.nodes[fault["node"]]
+            node.stop(signal.SIGKILL if kind == "kill" else signal.SIGTERM)
+            record["down_at"] = self.elapsed()
+            if "restart" in fault:
+                self.sleep_until(record["down_at"] + fault["restart"])
+                node.start()
+                record["restarted"] = self.elapsed()
+                ready = node.wait_ready(self.args.ready_timeout)
+                if ready is not None:
+                    record["node_recovery_s"] = ready
+        elif kind == "pause":
+            node = self.cluster.nodes[fault["node"]]
+            node.send_signal(signal.SIGSTOP)
+            self.stop_event.wait(fault.get("duration", 1.0))
+            node.send_signal(signal.SIGCONT)
+        elif kind == "delay":
+            with eloqdb_cluster.NetworkDelay(int(fault.get("ms", 50)),
+                                             int(fault.get("jitter", 0))):
+                self.stop_event.wait(fault.get("duration", 1.0))
+        record["ended"] = self.elapsed()
+        with self.lock:
+            self.fault_log.append(record)
+
+    def external_workload(self):
+        cmd = self.cluster.format_command(self.args.workload_cmd)
+        proc = subprocess.run(shlex.split(cmd), stdout=subprocess.PIPE,
+                              text=True)
+        if proc.returncode != 0:
+            raise RuntimeError("workload command exited with status %d: %s"
+                               % (proc.returncode, cmd))
+        lines = [l for l in proc.stdout.splitlines() if l.strip()]
+        try:
+            report = json.loads(lines[-1]) if lines else None
+        except ValueError:
+            report = None
+        if not isinstance(report, dict):
+            raise RuntimeError("workload command did not print a JSON report "
+                               "on its last line: %s" % cmd)
+        return report
+
+    def run(self):
+        workers = []
+        if not self.args.workload_cmd:
+            for i in range(self.args.clients):
+                node = self.cluster.nodes[i % len(self.cluster.nodes)]
+                workers.append(KvWorker(self, node, self.args.seed + i))
+        fault_threads = [threading.Thread(target=self.run_fault, args=(f,),
+                                          daemon=True)
+                         for f in self.args.inject]
+
+        self.start_time = time.monotonic()
+        for t in workers + fault_threads:
+            t.start()
+        external = None
+        try:
+            if self.args.workload_cmd:
+                external = self.external_workload()
+            else:
+                self.stop_event.wait(self.args.duration)
+        finally:
+            self.stop_event.set()
+            for t in workers + fault_threads:
+                t.join()
+
+        if external is not None:
+            return self.report(external.get("metrics", {}),
+                               *external_timeline(external), external)
+        hist = Histogram()
+        errors = 0
+        for w in workers:
+            hist.merge(w.hist)
+            errors += w.errors
+        metrics = {
+            "kv_ops_per_sec": hist.total / self.args.duration,
+            "kv_p50_latency_us": hist.percentile(50),
+            "kv_p99_latency_us": hist.percentile(99),
+            "kv_p999_latency_us": hist.percentile(99.9),
+            "kv_errors": errors,
+        }
+        return self.report(metrics, self.per_second[:int(self.args.duration)],
+                           0, None)
+
+    def report(self, metrics, timeline, offset, external):
+        """`timeline` holds ops per second starting `offset` seconds after
+        the workload started; it may be None when none is available."""
+        metrics = dict(metrics)
+        faults = sorted(self.fault_log, key=lambda f: f["started"])
+        baseline = None
+        if timeline:
+            end = offset + len(timeline)
+            first_fault = int(faults[0]["started"]) if faults else end
+            warmup = max(offset, min(int(self.args.warmup), first_fault))
+            steady = timeline[warmup - offset:max(0, first_fault - offset)]
+            if steady and sum(steady) > 0:
+                baseline = sum(steady) / len(steady)
+                metrics["baseline_ops_per_sec"] = baseline
+
+        for i, fault in enumerate(faults):
+            # Throughput recovery: first second after the fault ended whose
+            # throughput is back to the recovery fraction of the baseline.
+            # Without a non-zero baseline there is nothing to recover to.
+            first = max(int(math.ceil(fault["ended"])), offset)
+            for second in range(first, offset + len(timeline or [])):
+                if baseline is None:
+                    break
+                if (timeline[second - offset] >=
+                        baseline * self.args.recovery_fraction):
+                    fault["throughput_recovery_s"] = second - fault["started"]
+                    break
+            prefix = "fault%d_%s" % (i, fault["kind"])
+            for key in ("node_recovery_s", "throughput_recovery_s"):
+                if key in fault:
+                    metrics["%s_%s" % (prefix, key)] = fault[key]
+
+        result = {
+            "benchmark": "cluster_harness",
+            "config": {
+                "nodes": len(self.cluster.nodes),
+                "clients": self.args.clients,
+                "duration_s": self.args.duration,
+                "read_ratio": self.args.read_ratio,
+                "keys": self.args.keys,
+            },
+            "metrics": metrics,
+            "timeline_ops_per_sec": timeline or [],
+            "timeline_offset_s": offset,
+            "faults": faults,
+        }
+        if external is not None:
+            result["workload"] = external
+        return result
+
+
+def external_timeline(external):
+    """Per-second ops of an eloqdb_bench style report, summed over engines,
+    and the seconds after launch at which it starts."""
+    config = external.get("config", {})
+    if config.get("kv_rate") or config.get("sql_rate"):
+        # Open-loop timelines count operations by scheduled start, so they
+        # stay flat through a fault and say nothing about recovery.
+        return None, 0
+    series = [engine.get("ops_per_sec", [])
+              for engine in external.get("timeline", {}).values()]
+    if not any(series):
+        return None, 0
+    timeline = [0] * max(len(s) for s in series)
+    for s in series:
+        for second, ops in enumerate(s):
+            timeline[second] += ops
+    warmup = config.get("warmup_s", 0)
+    return timeline, int(math.ceil(warmup))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--eloqdb", required=True, help="eloqdb binary")
+    parser.add_argument("--workdir", default="cluster_harness_run")
+    parser.add_argument("--nodes", type=int, default=3)
+    parser.add_argument("--base-port", type=int, default=6389)
+    parser.add_argument("--port-step", type=int, default=10)
+    parser.add_argument("--kv-port-offset", type=int, default=0,
+                        help="RESP port relative to tx_port")
+    parser.add_argument("--sql-base-port", type=int, default=3317)
+    parser.add_argument("--with-sql", action="store_true",
+                        help="generate EloqSQL configs (eloqdb built with "
+                        "WITH_ELOQSQL)")
+    parser.add_argument("--ds-template",
+                        default=eloqdb_cluster.DEFAULT_DS_TEMPLATE)
+    parser.add_argument("--sql-template",
+                        default=eloqdb_cluster.DEFAULT_SQL_TEMPLATE)
+    parser.add_argument("--set", action="append", default=[],
+                        metavar="[SECTION.]KEY=VALUE",
+                        help="override a ds.cnf key on every node")
+    eloqdb_cluster.add_sql_arguments(parser)
+    parser.add_argument("--minio", help="minio binary to run as local S3")
+    parser.add_argument("--minio-port", type=int, default=9000)
+    parser.add_argument("--s3-endpoint", help="use an existing S3 endpoint")
+    parser.add_argument("--duration", type=float, default=60)
+    parser.add_argument("--warmup", type=float, default=5)
+    parser.add_argument("--clients", type=int, default=16)
+    parser.add_argument("--keys", type=int, default=100000)
+    parser.add_argument("--value-size", type=int, default=100)
+    parser.add_argument("--read-ratio", type=float, default=0.9)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--workload-cmd")
+    parser.add_argument("--inject", action="append", default=[],
+                        type=parse_fault, metavar="FAULT")
+    parser.add_argument("--recovery-fraction", type=float, default=0.9,
+                        help="throughput fraction of the pre-fault baseline "
+                        "that counts as recovered")
+    parser.add_argument("--ready-timeout", type=float, default=600)
+    parser.add_argument("--output", help="write the JSON report here")
+    args = parser.parse_args()
+
+    cluster = eloqdb_cluster.Cluster(
+        args.eloqdb, args.workdir, nodes=args.nodes, base_port=args.base_port,
+        port_step=args.port_step, kv_port_offset=args.kv_port_offset,
+        sql_base_port=args.sql_base_port, with_sql=args.with_sql,
+        ds_template=args.ds_template, sql_template=args.sql_template,
+        s3_endpoint=args.s3_endpoint, minio=args.minio,
+        minio_port=args.minio_port,
+        ds_overrides=eloqdb_cluster.parse_overrides(args.set, "local"),
+        sql_overrides=eloqdb_cluster.parse_overrides(args.sql_set, "mariadb"),
+        sql_install_db=args.sql_install_db)
+
+    with cluster:
+        ready = cluster.start(ready_timeout=args.ready_timeout)
+        print("cluster of %d nodes ready (max %.2fs)"
+              % (len(cluster.nodes), max(ready.values())), file=sys.stderr)
+        result = Harness(args, cluster).run()
+    result["metrics"]["cluster_startup_s"] = max(ready.values())
+
+    text = json.dumps(result, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    for name, value in sorted(result["metrics"].items()):
+        print("%-40s %12.2f" % (name, value), file=sys.stderr)
+    print(json.dumps(result))
+
+
+if __name__ == "__main__":
+    main()
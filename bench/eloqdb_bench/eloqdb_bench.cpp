@@ -0,0 +1,556 @@
+/**
+ * eloqdb_bench - mixed KV + SQL load driver for the converged binary
+ *
+ * Drives one eloqdb node (or several) with two independent client pools
+ * at the same time:
+ * - KV: YCSB-style operations over RESP (--kv_threads clients)
+ * - SQL: TPC-C-like transactions over the MySQL protocol (--sql_threads
+ *   clients, only when built with a MySQL client library)
+ * The KV:SQL mix is set by the two pool sizes. Clients run closed-loop, or
+ * open-loop at a fixed aggregate rate per engine with --kv_rate/--sql_rate.
+ *
+ * Reports throughput and latency percentiles per engine and per operation
+ * on stderr, and as one JSON object on the last line of stdout (and in
+ * --json_output) so runs of different builds can be compared.
+ */
+
+#include <gflags/gflags.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "kv_workload.h"
+#include "latency_histogram.h"
+#include "workload.h"
+#ifdef ELOQDB_BENCH_WITH_SQL
+#include "sql_workload.h"
+#endif
+
+#ifdef ELOQDB_BENCH_WITH_SQL
+constexpr int kDefaultSqlThreads = 8;
+#else
+constexpr int kDefaultSqlThreads = 0;
+#endif
+
+// Phases and timing
+DEFINE_bool(load, false, "Load KV records and SQL tables before running");
+DEFINE_bool(run, true, "Run the timed workload");
+DEFINE_int32(load_threads, 16, "Connections used per engine while loading");
+DEFINE_double(warmup, 10, "Seconds of load before measuring starts");
+DEFINE_double(duration, 60, "Seconds of measured load");
+DEFINE_uint64(seed, 1, "Random seed; thread i uses seed + i");
+DEFINE_string(label, "", "Free-form label stored in the JSON report");
+DEFINE_string(json_output, "", "Also write the JSON report to this file");
+DEFINE_int32(io_timeout_ms, 30000,
+             "Socket timeout per KV request and SQL connect/read/write; a "
+             "request that times out counts as an error. 0 waits forever");
+
+// KV workload
+DEFINE_string(kv_endpoints, "127.0.0.1:6389",
+              "Comma-separated RESP host:port list; clients round-robin");
+DEFINE_int32(kv_threads, 8, "Number of concurrent KV clients");
+DEFINE_double(kv_rate, 0,
+              "Open-loop KV rate in ops/s across all KV clients; 0 runs the "
+              "clients closed-loop");
+DEFINE_string(ycsb_workload, "a", "YCSB core workload preset: a, b, c, d, f");
+DEFINE_uint64(record_count, 100000, "Number of KV records");
+DEFINE_int32(field_count, 10, "Fields per KV record (hash)");
+DEFINE_int32(field_length, 100, "Bytes per field");
+DEFINE_string(request_distribution, "",
+              "uniform, zipfian or latest; empty keeps the preset's");
+DEFINE_double(zipf_constant, 0.99, "Zipfian skew");
+// Operation mix; after overrides the four proportions must sum to 1.
+DEFINE_double(read_proportion, -1, "Overrides the preset when >= 0");
+DEFINE_double(update_proportion, -1, "Overrides the preset when >= 0");
+DEFINE_double(insert_proportion, -1, "Overrides the preset when >= 0");
+DEFINE_double(rmw_proportion, -1, "Overrides the preset when >= 0");
+
+// SQL workload
+DEFINE_string(sql_endpoints, "127.0.0.1:3317",
+              "Comma-separated MySQL host:port list; clients round-robin");
+DEFINE_int32(sql_threads, kDefaultSqlThreads,
+             "Number of concurrent SQL clients");
+DEFINE_double(sql_rate, 0,
+              "Open-loop SQL rate in transactions/s across all SQL clients; "
+              "0 runs the clients closed-loop");
+DEFINE_string(sql_user, "root", "MySQL user");
+DEFINE_string(sql_password, "", "MySQL password");
+DEFINE_string(sql_database, "eloqdb_bench", "Database holding the tables");
+DEFINE_string(sql_engine, "ELOQ",
+              "ENGINE= for created tables; empty for the server default");
+DEFINE_int32(warehouses, 1, "TPC-C warehouses");
+DEFINE_int32(items, 100000, "TPC-C items (and stock rows per warehouse)");
+DEFINE_int32(customers_per_district, 3000, "TPC-C customers per district");
+DEFINE_string(sql_mix, "45,43,12",
+              "Weights of NewOrder, Payment and OrderStatus");
+
+namespace eloqdb_bench {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct OpStats {
+  LatencyHistogram latency;
+  uint64_t aborts = 0;
+  uint64_t errors = 0;
+
+  void Merge(const OpStats &other) {
+    latency.Merge(other.latency);
+    aborts += other.aborts;
+    errors += other.errors;
+  }
+};
+
+// Operation name -> stats. Names are static strings from the workloads.
+using StatsMap = std::map<std::string_view, OpStats>;
+
+struct RunWindow {
+  Clock::time_point measure_start;
+  Clock::time_point measure_end;
+};
+
+struct ClientStats {
+  std::string engine;
+  StatsMap ops;
+  // Completed operations and worst latency per measured second (by
+  // scheduled start in open-loop mode).
+  std::vector<uint64_t> second_ops;
+  std::vector<uint64_t> second_max_ns;
+};
+
+// Runs one client until the end of the window. With a non-zero `interval`
+// the client is open-loop: operations are scheduled every `interval`
+// (starting `phase` into the schedule) and latency is measured from the
+// scheduled start rather than the actual send, so time a request spent
+// waiting behind a stalled one is counted instead of silently omitted.
+// Open-loop operations are attributed to the window by their scheduled
+// start, and the client keeps running past the window until every
+// operation scheduled inside it has completed, so a stall that crosses the
+// end of the run still reports its whole backlog.
+void RunClient(Workload *workload, const RunWindow &window,
+               Clock::duration interval, Clock::duration phase,
+               ClientStats *stats) {
+  Clock::time_point scheduled = Clock::now() + phase;
+  while (true) {
+    Clock::time_point begin;
+    if (interval > Clock::duration::zero()) {
+      if (scheduled >= window.measure_end) {
+        break;
+      }
+      std::this_thread::sleep_until(scheduled);
+      begin = scheduled;
+      scheduled += interval;
+    } else {
+      begin = Clock::now();
+      if (begin >= window.measure_end) {
+        break;
+      }
+    }
+    OpResult result = workload->RunOne();
+    Clock::time_point end = Clock::now();
+    Clock::time_point at =
+        interval > Clock::duration::zero() ? begin : end;
+    if (at < window.measure_start || at >= window.measure_end) {
+      continue;
+    }
+    OpStats &op = stats->ops[result.op];
+    uint64_t latency_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+            .count();
+    size_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                        at - window.measure_start)
+                        .count();
+    if (second >= stats->second_ops.size()) {
+      stats->second_ops.resize(second + 1, 0);
+      stats->second_max_ns.resize(second + 1, 0);
+    }
+    switch (result.status) {
+    case OpStatus::kOk:
+      op.latency.Record(latency_ns);
+      ++stats->second_ops[second];
+      stats->second_max_ns[second] =
+          std::max(stats->second_max_ns[second], latency_ns);
+      break;
+    case OpStatus::kAbort:
+      ++op.aborts;
+      break;
+    case OpStatus::kError:
+      ++op.errors;
+      break;
+    }
+  }
+}
+
+std::string JsonEscape(std::string_view s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+std::string JsonNumber(double v) {
+  if (!std::isfinite(v)) {
+    return "null";
+  }
+  std::ostringstream ss;
+  ss << std::setprecision(10) << v;
+  return ss.str();
+}
+
+// Appends `"key": value` pairs of one JSON object.
+class JsonFields {
+ public:
+  JsonFields &Add(std::string_view key, const std::string &raw_value) {
+    out_ += out_.empty() ? "{" : ",";
+    out_ += JsonEscape(key) + ":" + raw_value;
+    return *this;
+  }
+  JsonFields &Num(std::string_view key, double v) {
+    return Add(key, JsonNumber(v));
+  }
+  JsonFields &Str(std::string_view key, std::string_view v) {
+    return Add(key, JsonEscape(v));
+  }
+  std::string Close() const { return out_.empty() ? "{}" : out_ + "}"; }
+
+ private:
+  std::string out_;
+};
+
+double Us(uint64_t ns) { return ns / 1000.0; }
+
+// Adds throughput, latency percentiles (us), abort and error counts of
+// `stats` under `prefix`.
+void AddStats(JsonFields *fields, const std::string &prefix,
+              const OpStats &stats, double seconds) {
+  const LatencyHistogram &h = stats.latency;
+  fields->Num(prefix + "ops_per_sec", h.Count() / seconds)
+      .Num(prefix + "mean_latency_us", h.Mean() / 1000.0)
+      .Num(prefix + "p50_latency_us", Us(h.Percentile(50)))
+      .Num(prefix + "p90_latency_us", Us(h.Percentile(90)))
+      .Num(prefix + "p99_latency_us", Us(h.Percentile(99)))
+      .Num(prefix + "p999_latency_us", Us(h.Percentile(99.9)))
+      .Num(prefix + "max_latency_us", Us(h.Max()))
+      .Num(prefix + "aborts", stats.aborts)
+      .Num(prefix + "errors", stats.errors);
+}
+
+void PrintStats(std::string_view name, const OpStats &stats, double seconds) {
+  const LatencyHistogram &h = stats.latency;
+  std::fprintf(stderr,
+               "%-18.*s %12.1f %10.1f %10.1f %10.1f %10.1f %8lu %8lu\n",
+               static_cast<int>(name.size()), name.data(),
+               h.Count() / seconds, Us(h.Percentile(50)),
+               Us(h.Percentile(99)), Us(h.Percentile(99.9)), Us(h.Max()),
+               static_cast<unsigned long>(stats.aborts),
+               static_cast<unsigned long>(stats.errors));
+}
+
+std::string JsonArray(const std::vector<double> &values) {
+  std::string out = "[";
+  for (size_t i = 0; i < values.size(); ++i) {
+    out += (i == 0 ? "" : ",") + JsonNumber(values[i]);
+  }
+  return out + "]";
+}
+
+// Per-engine throughput and worst latency for every measured second, so
+// latency spikes can be lined up with background work on the server.
+std::string Timeline(const std::vector<ClientStats> &clients, double seconds) {
+  size_t len = static_cast<size_t>(std::ceil(seconds));
+  std::map<std::string, std::pair<std::vector<double>, std::vector<double>>>
+      engines;
+  for (const ClientStats &client : clients) {
+    auto &[ops, max_us] = engines[client.engine];
+    ops.resize(len, 0);
+    max_us.resize(len, 0);
+    for (size_t i = 0; i < client.second_ops.size() && i < len; ++i) {
+      ops[i] += client.second_ops[i];
+      max_us[i] = std::max(max_us[i], Us(client.second_max_ns[i]));
+    }
+  }
+  JsonFields timeline;
+  for (const auto &[engine, series] : engines) {
+    timeline.Add(engine, JsonFields()
+                             .Add("ops_per_sec", JsonArray(series.first))
+                             .Add("max_latency_us", JsonArray(series.second))
+                             .Close());
+  }
+  return timeline.Close();
+}
+
+std::string Report(const std::vector<ClientStats> &clients, double seconds) {
+  StatsMap ops;
+  for (const ClientStats &client : clients) {
+    for (const auto &[name, op] : client.ops) {
+      ops[name].Merge(op);
+    }
+  }
+
+  std::map<std::string, OpStats> engines;
+  for (const auto &[name, stats] : ops) {
+    std::string engine(name.substr(0, name.find('.')));
+    engines[engine].Merge(stats);
+  }
+
+  std::fprintf(stderr, "%-18s %12s %10s %10s %10s %10s %8s %8s\n", "op",
+               "ops/s", "p50(us)", "p99(us)", "p999(us)", "max(us)", "aborts",
+               "errors");
+  JsonFields metrics;
+  for (const auto &[engine, stats] : engines) {
+    PrintStats(engine, stats, seconds);
+    AddStats(&metrics, engine + "_", stats, seconds);
+  }
+  JsonFields per_op;
+  for (const auto &[name, stats] : ops) {
+    PrintStats(name, stats, seconds);
+    JsonFields op;
+    AddStats(&op, "", stats, seconds);
+    per_op.Add(name, op.Close());
+  }
+
+  JsonFields config;
+  config.Str("label", FLAGS_label)
+      .Num("duration_s", FLAGS_duration)
+      .Num("warmup_s", FLAGS_warmup)
+      .Num("io_timeout_ms", FLAGS_io_timeout_ms)
+      .Num("kv_threads", FLAGS_kv_threads)
+      .Num("kv_rate", FLAGS_kv_rate)
+      .Str("kv_endpoints", FLAGS_kv_endpoints)
+      .Str("ycsb_workload", FLAGS_ycsb_workload)
+      .Num("record_count", FLAGS_record_count)
+      .Num("field_count", FLAGS_field_count)
+      .Num("field_length", FLAGS_field_length)
+      .Num("sql_threads", FLAGS_sql_threads)
+      .Num("sql_rate", FLAGS_sql_rate)
+      .Str("sql_endpoints", FLAGS_sql_endpoints)
+      .Str("sql_engine", FLAGS_sql_engine)
+      .Num("warehouses", FLAGS_warehouses)
+      .Str("sql_mix", FLAGS_sql_mix);
+
+  return JsonFields()
+      .Str("benchmark", "eloqdb_bench")
+      .Add("config", config.Close())
+      .Add("metrics", metrics.Close())
+      .Add("ops", per_op.Close())
+      .Add("timeline", Timeline(clients, seconds))
+      .Close();
+}
+
+bool BuildKvConfig(KvConfig *config) {
+  if (!ParseEndpoints(FLAGS_kv_endpoints, &config->endpoints)) {
+    std::cerr << "Invalid --kv_endpoints: " << FLAGS_kv_endpoints << std::endl;
+    return false;
+  }
+  if (!ApplyYcsbPreset(FLAGS_ycsb_workload, config)) {
+    std::cerr << "Unsupported --ycsb_workload: " << FLAGS_ycsb_workload
+              << std::endl;
+    return false;
+  }
+  config->record_count = FLAGS_record_count;
+  config->field_count = FLAGS_field_count;
+  config->field_length = FLAGS_field_length;
+  config->zipf_constant = FLAGS_zipf_constant;
+  config->io_timeout_ms = std::max(0, FLAGS_io_timeout_ms);
+  if (!FLAGS_request_distribution.empty()) {
+    config->distribution = FLAGS_request_distribution;
+  }
+  if (FLAGS_read_proportion >= 0) {
+    config->read_proportion = FLAGS_read_proportion;
+  }
+  if (FLAGS_update_proportion >= 0) {
+    config->update_proportion = FLAGS_update_proportion;
+  }
+  if (FLAGS_insert_proportion >= 0) {
+    config->insert_proportion = FLAGS_insert_proportion;
+  }
+  if (FLAGS_rmw_proportion >= 0) {
+    config->rmw_proportion = FLAGS_rmw_proportion;
+  }
+  double total = config->read_proportion + config->update_proportion +
+                 config->insert_proportion + config->rmw_proportion;
+  if (std::fabs(total - 1.0) > 1e-6) {
+    std::cerr << "KV operation proportions (read " << config->read_proportion
+              << ", update " << config->update_proportion << ", insert "
+              << config->insert_proportion << ", rmw "
+              << config->rmw_proportion << ") must sum to 1, not " << total
+              << std::endl;
+    return false;
+  }
+  return config->record_count > 0 && config->field_count > 0;
+}
+
+bool LoadKv(const KvShared &shared) {
+  int threads = std::max(1, FLAGS_load_threads);
+  uint64_t total = shared.config.record_count;
+  std::vector<uint64_t> failed(threads, 0);
+  std::vector<std::string> errors(threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      const std::vector<Endpoint> &endpoints = shared.config.endpoints;
+      failed[t] = LoadKvRange(shared, endpoints[t % endpoints.size()],
+                              total * t / threads, total * (t + 1) / threads,
+                              &errors[t]);
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  for (int t = 0; t < threads; ++t) {
+    if (failed[t] > 0) {
+      std::cerr << "KV load failed for " << failed[t]
+                << " records: " << errors[t] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int Main() {
+  KvConfig kv_config;
+  if (FLAGS_kv_threads > 0 && !BuildKvConfig(&kv_config)) {
+    return 1;
+  }
+  std::unique_ptr<KvShared> kv_shared;
+  if (FLAGS_kv_threads > 0) {
+    kv_shared = std::make_unique<KvShared>(kv_config);
+  }
+
+#ifdef ELOQDB_BENCH_WITH_SQL
+  SqlConfig sql_config;
+  if (FLAGS_sql_threads > 0) {
+    if (!ParseEndpoints(FLAGS_sql_endpoints, &sql_config.endpoints) ||
+        !ParseSqlMix(FLAGS_sql_mix, &sql_config)) {
+      std::cerr << "Invalid --sql_endpoints or --sql_mix" << std::endl;
+      return 1;
+    }
+    sql_config.user = FLAGS_sql_user;
+    sql_config.password = FLAGS_sql_password;
+    sql_config.database = FLAGS_sql_database;
+    sql_config.engine = FLAGS_sql_engine;
+    sql_config.warehouses = std::max(1, FLAGS_warehouses);
+    sql_config.items = std::max(1, FLAGS_items);
+    sql_config.customers_per_district = std::max(1, FLAGS_customers_per_district);
+    sql_config.io_timeout_ms = std::max(0, FLAGS_io_timeout_ms);
+  }
+#else
+  if (FLAGS_sql_threads > 0) {
+    std::cerr << "eloqdb_bench was built without a MySQL client library; "
+                 "use --sql_threads=0"
+              << std::endl;
+    return 1;
+  }
+#endif
+
+  if (FLAGS_load) {
+    auto start = Clock::now();
+    if (kv_shared && !LoadKv(*kv_shared)) {
+      return 1;
+    }
+#ifdef ELOQDB_BENCH_WITH_SQL
+    std::string error;
+    if (FLAGS_sql_threads > 0 &&
+        !LoadSql(sql_config, std::max(1, FLAGS_load_threads), &error)) {
+      std::cerr << "SQL load failed: " << error << std::endl;
+      return 1;
+    }
+#endif
+    std::cerr << "Load finished in "
+              << std::chrono::duration<double>(Clock::now() - start).count()
+              << "s" << std::endl;
+  }
+  if (!FLAGS_run) {
+    return 0;
+  }
+
+  std::vector<std::unique_ptr<Workload>> workloads;
+  for (int i = 0; i < FLAGS_kv_threads; ++i) {
+    workloads.push_back(NewKvWorkload(kv_shared.get(), i, FLAGS_seed + i));
+  }
+#ifdef ELOQDB_BENCH_WITH_SQL
+  for (int i = 0; i < FLAGS_sql_threads; ++i) {
+    workloads.push_back(NewSqlWorkload(sql_config, i,
+                                       FLAGS_seed + FLAGS_kv_threads + i));
+  }
+#endif
+  if (workloads.empty()) {
+    std::cerr << "Nothing to run: --kv_threads and --sql_threads are 0"
+              << std::endl;
+    return 1;
+  }
+
+  RunWindow window;
+  window.measure_start =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(FLAGS_warmup));
+  window.measure_end =
+      window.measure_start + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(FLAGS_duration));
+
+  // Open-loop clients of an engine share its rate evenly and are staggered
+  // across one interval so their requests do not arrive in bursts.
+  auto interval_of = [](double rate, int clients) {
+    return rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(clients / rate))
+                    : Clock::duration::zero();
+  };
+  Clock::duration kv_interval = interval_of(FLAGS_kv_rate, FLAGS_kv_threads);
+  Clock::duration sql_interval =
+      interval_of(FLAGS_sql_rate, FLAGS_sql_threads);
+
+  std::vector<ClientStats> client_stats(workloads.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workloads.size(); ++i) {
+    bool kv = i < static_cast<size_t>(FLAGS_kv_threads);
+    int index = kv ? i : i - FLAGS_kv_threads;
+    int clients = kv ? FLAGS_kv_threads : FLAGS_sql_threads;
+    Clock::duration interval = kv ? kv_interval : sql_interval;
+    client_stats[i].engine = kv ? "kv" : "sql";
+    threads.emplace_back(RunClient, workloads[i].get(), std::cref(window),
+                         interval, interval * index / clients,
+                         &client_stats[i]);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  std::string json = Report(client_stats, FLAGS_duration);
+  if (!FLAGS_json_output.empty()) {
+    std::ofstream(FLAGS_json_output) << json << std::endl;
+  }
+  std::cout << json << std::endl;
+  return 0;
+}
+
+}  // namespace
+}  // namespace eloqdb_bench
+
+int main(int argc, char *argv[]) {
+  google::SetUsageMessage("Mixed KV + SQL load driver for eloqdb");
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  return eloqdb_bench::Main();
+}
@@ -0,0 +1,236 @@
+#include "kv_workload.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string_view>
+#include <thread>
+
+#include "resp_client.h"
+
+namespace eloqdb_bench {
+
+namespace {
+
+double Zeta(uint64_t n, double theta) {
+  double sum = 0;
+  for (uint64_t i = 1; i <= n; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i), theta);
+  }
+  return sum;
+}
+
+std::string FieldName(int field) { return "field" + std::to_string(field); }
+
+class KvWorkload : public Workload {
+ public:
+  KvWorkload(KvShared *shared, int thread_index, uint64_t seed)
+      : shared_(shared),
+        config_(shared->config),
+        client_(config_.endpoints[thread_index % config_.endpoints.size()].host,
+                config_.endpoints[thread_index % config_.endpoints.size()].port,
+                config_.io_timeout_ms),
+        rng_(seed) {
+    // A random pool of value bytes; each write takes a window of it so
+    // values differ without generating fresh random data per operation.
+    std::uniform_int_distribution<int> printable('a', 'z');
+    value_pool_.resize(config_.field_length * 2);
+    for (char &c : value_pool_) {
+      c = static_cast<char>(printable(rng_));
+    }
+    for (int i = 0; i < config_.field_count; ++i) {
+      fields_.push_back(FieldName(i));
+    }
+  }
+
+  OpResult RunOne() override {
+    double op = uniform_(rng_);
+    if (op < config_.read_proportion) {
+      return {"kv.read", Read(ChooseKey())};
+    }
+    op -= config_.read_proportion;
+    if (op < config_.update_proportion) {
+      return {"kv.update", Update(ChooseKey())};
+    }
+    op -= config_.update_proportion;
+    if (op < config_.insert_proportion) {
+      uint64_t keynum = shared_->next_insert.fetch_add(1);
+      return {"kv.insert", Insert(keynum)};
+    }
+    op -= config_.insert_proportion;
+    if (op < config_.rmw_proportion) {
+      OpStatus status = Read(ChooseKey());
+      if (status == OpStatus::kOk) {
+        status = Update(last_key_);
+      }
+      return {"kv.rmw", status};
+    }
+    // Only reachable through rounding; the proportions sum to 1.
+    return {"kv.read", Read(ChooseKey())};
+  }
+
+ private:
+  uint64_t ChooseKey() {
+    uint64_t limit = shared_->next_insert.load(std::memory_order_relaxed);
+    uint64_t keynum;
+    if (config_.distribution == "uniform") {
+      keynum = std::uniform_int_distribution<uint64_t>(0, limit - 1)(rng_);
+    } else if (config_.distribution == "latest") {
+      uint64_t back = shared_->zipfian.Next(uniform_(rng_));
+      keynum = back < limit ? limit - 1 - back : 0;
+    } else {
+      // Scrambled zipfian: popular items are spread over the key space.
+      keynum = FnvHash64(shared_->zipfian.Next(uniform_(rng_))) %
+               config_.record_count;
+    }
+    last_key_ = keynum;
+    return keynum;
+  }
+
+  std::string_view Value() {
+    size_t offset = std::uniform_int_distribution<size_t>(
+        0, config_.field_length)(rng_);
+    return std::string_view(value_pool_).substr(offset, config_.field_length);
+  }
+
+  OpStatus Execute(const std::vector<std::string_view> &args) {
+    if (!client_.Connected() && !client_.Connect()) {
+      // Back off so an unreachable server does not turn into a busy loop.
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      return OpStatus::kError;
+    }
+    if (!client_.Command(args, &reply_)) {
+      return OpStatus::kError;
+    }
+    return reply_.IsError() ? OpStatus::kError : OpStatus::kOk;
+  }
+
+  OpStatus Read(uint64_t keynum) {
+    key_ = KvKey(keynum);
+    return Execute({"HGETALL", key_});
+  }
+
+  OpStatus Update(uint64_t keynum) {
+    key_ = KvKey(keynum);
+    int field = std::uniform_int_distribution<int>(
+        0, config_.field_count - 1)(rng_);
+    return Execute({"HSET", key_, fields_[field], Value()});
+  }
+
+  OpStatus Insert(uint64_t keynum) {
+    key_ = KvKey(keynum);
+    args_.assign({"HSET", key_});
+    for (const std::string &field : fields_) {
+      args_.push_back(field);
+      args_.push_back(Value());
+    }
+    return Execute(args_);
+  }
+
+  KvShared *shared_;
+  const KvConfig &config_;
+  RespClient client_;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+  std::string value_pool_;
+  std::vector<std::string> fields_;
+  std::vector<std::string_view> args_;
+  std::string key_;
+  uint64_t last_key_ = 0;
+  RespReply reply_;
+};
+
+}  // namespace
+
+bool ApplyYcsbPreset(const std::string &name, KvConfig *config) {
+  config->read_proportion = 0;
+  config->update_proportion = 0;
+  config->insert_proportion = 0;
+  config->rmw_proportion = 0;
+  if (name == "a") {
+    config->read_proportion = 0.5;
+    config->update_proportion = 0.5;
+  } else if (name == "b") {
+    config->read_proportion = 0.95;
+    config->update_proportion = 0.05;
+  } else if (name == "c") {
+    config->read_proportion = 1.0;
+  } else if (name == "d") {
+    config->read_proportion = 0.95;
+    config->insert_proportion = 0.05;
+    config->distribution = "latest";
+  } else if (name == "f") {
+    config->read_proportion = 0.5;
+    config->rmw_proportion = 0.5;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+ZipfianGenerator::ZipfianGenerator(uint64_t items, double theta)
+    : items_(items), theta_(theta) {
+  zetan_ = Zeta(items, theta);
+  alpha_ = 1.0 / (1.0 - theta);
+  double zeta2 = Zeta(2, theta);
+  eta_ = (1.0 - std::pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+}
+
+uint64_t ZipfianGenerator::Next(double uniform) const {
+  double uz = uniform * zetan_;
+  if (uz < 1.0) {
+    return 0;
+  }
+  if (uz < 1.0 + std::pow(0.5, theta_)) {
+    return 1;
+  }
+  uint64_t item = static_cast<uint64_t>(
+      items_ * std::pow(eta_ * uniform - eta_ + 1.0, alpha_));
+  return item < items_ ? item : items_ - 1;
+}
+
+KvShared::KvShared(const KvConfig &config)
+    : config(config),
+      zipfian(config.record_count, config.zipf_constant),
+      next_insert(config.record_count) {}
+
+std::string KvKey(uint64_t keynum) {
+  return "user" + std::to_string(FnvHash64(keynum));
+}
+
+uint64_t LoadKvRange(const KvShared &shared, const Endpoint &endpoint,
+                     uint64_t begin, uint64_t end, std::string *error) {
+  const KvConfig &config = shared.config;
+  RespClient client(endpoint.host, endpoint.port, config.io_timeout_ms);
+  std::string value(config.field_length, 'v');
+  std::vector<std::string> fields;
+  for (int i = 0; i < config.field_count; ++i) {
+    fields.push_back(FieldName(i));
+  }
+  std::vector<std::string_view> args;
+  RespReply reply;
+  uint64_t failed = 0;
+  for (uint64_t keynum = begin; keynum < end; ++keynum) {
+    std::string key = KvKey(keynum);
+    args.assign({"HSET", key});
+    for (const std::string &field : fields) {
+      args.push_back(field);
+      args.push_back(value);
+    }
+    if (!client.Command(args, &reply)) {
+      *error = client.LastError();
+      ++failed;
+    } else if (reply.IsError()) {
+      *error = reply.str;
+      ++failed;
+    }
+  }
+  return failed;
+}
+
+std::unique_ptr<Workload> NewKvWorkload(KvShared *shared, int thread_index,
+                                        uint64_t seed) {
+  return std::make_unique<KvWorkload>(shared, thread_index, seed);
+}
+
+}  // namespace eloqdb_bench
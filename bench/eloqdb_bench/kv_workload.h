@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+
+namespace eloqdb_bench {
+
+// YCSB-style key-value workload over RESP. Records are hashes with
+// `field_count` fields, as in the YCSB Redis binding.
+struct KvConfig {
+  std::vector<Endpoint> endpoints;
+  uint64_t record_count = 100000;
+  int field_count = 10;
+  int field_length = 100;
+  double read_proportion = 0.5;
+  double update_proportion = 0.5;
+  double insert_proportion = 0;
+  double rmw_proportion = 0;
+  // uniform, zipfian or latest.
+  std::string distribution = "zipfian";
+  double zipf_constant = 0.99;
+  // Per-request socket timeout; 0 waits forever.
+  int io_timeout_ms = 0;
+};
+
+// Applies the operation mix of YCSB core workload a, b, c, d or f.
+// Workload e (short scans) has no RESP equivalent and is rejected.
+bool ApplyYcsbPreset(const std::string &name, KvConfig *config);
+
+// Zipfian generator over [0, items) following Gray et al., as used by
+// YCSB. The zeta constants are computed once and shared by all threads.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t items, double theta);
+  // Maps a uniform sample in [0, 1) to a zipfian-distributed item.
+  uint64_t Next(double uniform) const;
+
+ private:
+  uint64_t items_;
+  double theta_;
+  double zetan_;
+  double alpha_;
+  double eta_;
+};
+
+// State shared by all KV threads of a run.
+struct KvShared {
+  explicit KvShared(const KvConfig &config);
+
+  KvConfig config;
+  ZipfianGenerator zipfian;
+  // Next key number to insert; keys below it are known to exist.
+  std::atomic<uint64_t> next_insert;
+};
+
+std::string KvKey(uint64_t keynum);
+
+// Inserts keys [begin, end) through one connection to `endpoint`. Returns
+// the number of failed inserts.
+uint64_t LoadKvRange(const KvShared &shared, const Endpoint &endpoint,
+                     uint64_t begin, uint64_t end, std::string *error);
+
+std::unique_ptr<Workload> NewKvWorkload(KvShared *shared, int thread_index,
+                                        uint64_t seed);
+
+}  // namespace eloqdb_bench
@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace eloqdb_bench {
+
+// Fixed-size log-linear histogram of latencies in nanoseconds. Values below
+// 64 are exact, larger ones land in one of 64 linear sub-buckets of their
+// power of two, which bounds the relative error to ~1.6%. Recording is a
+// couple of instructions, so every worker thread keeps its own histograms
+// and they are merged once at the end of the run.
+class LatencyHistogram {
+ public:
+  void Record(uint64_t ns) {
+    ++counts_[Index(ns)];
+    ++count_;
+    sum_ += ns;
+    max_ = std::max(max_, ns);
+  }
+
+  void Merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return count_; }
+  uint64_t Max() const { return max_; }
+  double Mean() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+  }
+
+  // Returns the upper bound of the bucket holding the given percentile
+  // (0-100], capped at the largest recorded value.
+  uint64_t Percentile(double pct) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(pct / 100.0 * count_ + 0.5);
+    target = std::clamp<uint64_t>(target, 1, count_);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= target) {
+        return std::min(UpperBound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr int kSubBucketBits = 6;
+  static constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;
+  static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t Index(uint64_t v) {
+    if (v < kSubBuckets) {
+      return v;
+    }
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) +
+           ((v >> shift) & (kSubBuckets - 1));
+  }
+
+  static uint64_t UpperBound(size_t index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    uint64_t sub = index & (kSubBuckets - 1);
+    return ((kSubBuckets + sub) << shift) + ((1ULL << shift) - 1);
+  }
+
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+};
+
+}  // namespace eloqdb_bench
@@ -0,0 +1,202 @@
+#include "resp_client.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace eloqdb_bench {
+
+RespClient::RespClient(std::string host, uint16_t port, int timeout_ms)
+    : host_(std::move(host)), port_(port), timeout_ms_(timeout_ms) {}
+
+RespClient::~RespClient() { Close(); }
+
+bool RespClient::Connect() {
+  Close();
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *result = nullptr;
+  std::string port = std::to_string(port_);
+  int rc = getaddrinfo(host_.c_str(), port.c_str(), &hints, &result);
+  if (rc != 0) {
+    last_error_ = gai_strerror(rc);
+    return false;
+  }
+  for (addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+    int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (timeout_ms_ > 0) {
+      // On Linux SO_SNDTIMEO also bounds connect().
+      timeval tv{timeout_ms_ / 1000, (timeout_ms_ % 1000) * 1000};
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      fd_ = fd;
+      break;
+    }
+    last_error_ = std::strerror(errno);
+    close(fd);
+  }
+  freeaddrinfo(result);
+  return fd_ >= 0;
+}
+
+void RespClient::Close() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  in_.clear();
+  in_pos_ = 0;
+}
+
+bool RespClient::Command(const std::vector<std::string_view> &args,
+                         RespReply *reply) {
+  if (fd_ < 0 && !Connect()) {
+    return false;
+  }
+  out_.clear();
+  out_ += '*';
+  out_ += std::to_string(args.size());
+  out_ += "\r\n";
+  for (std::string_view arg : args) {
+    out_ += '$';
+    out_ += std::to_string(arg.size());
+    out_ += "\r\n";
+    out_.append(arg.data(), arg.size());
+    out_ += "\r\n";
+  }
+  size_t sent = 0;
+  while (sent < out_.size()) {
+    ssize_t n = send(fd_, out_.data() + sent, out_.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      last_error_ = std::strerror(errno);
+      Close();
+      return false;
+    }
+    sent += n;
+  }
+  if (!ReadReply(reply)) {
+    Close();
+    return false;
+  }
+  // Compact the input buffer once everything buffered has been consumed.
+  if (in_pos_ == in_.size()) {
+    in_.clear();
+    in_pos_ = 0;
+  }
+  return true;
+}
+
+bool RespClient::Fill() {
+  char buf[16384];
+  while (true) {
+    ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+    if (n > 0) {
+      in_.append(buf, n);
+      return true;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n == 0) {
+      last_error_ = "connection closed";
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      last_error_ = "timed out waiting for reply";
+    } else {
+      last_error_ = std::strerror(errno);
+    }
+    return false;
+  }
+}
+
+bool RespClient::ReadLine(std::string_view *line) {
+  while (true) {
+    size_t end = in_.find("\r\n", in_pos_);
+    if (end != std::string::npos) {
+      *line = std::string_view(in_).substr(in_pos_, end - in_pos_);
+      in_pos_ = end + 2;
+      return true;
+    }
+    if (!Fill()) {
+      return false;
+    }
+  }
+}
+
+bool RespClient::ReadReply(RespReply *reply) {
+  std::string_view line;
+  if (!ReadLine(&line) || line.empty()) {
+    last_error_ = last_error_.empty() ? "malformed reply" : last_error_;
+    return false;
+  }
+  char kind = line[0];
+  std::string_view body = line.substr(1);
+  reply->elements.clear();
+  switch (kind) {
+  case '+':
+    reply->type = RespReply::Type::kStatus;
+    reply->str.assign(body);
+    return true;
+  case '-':
+    reply->type = RespReply::Type::kError;
+    reply->str.assign(body);
+    return true;
+  case ':':
+    reply->type = RespReply::Type::kInteger;
+    reply->integer = std::strtoll(std::string(body).c_str(), nullptr, 10);
+    return true;
+  case '$': {
+    int64_t len = std::strtoll(std::string(body).c_str(), nullptr, 10);
+    if (len < 0) {
+      reply->type = RespReply::Type::kNil;
+      return true;
+    }
+    while (in_.size() - in_pos_ < static_cast<size_t>(len) + 2) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+    reply->type = RespReply::Type::kBulk;
+    reply->str.assign(in_, in_pos_, len);
+    in_pos_ += len + 2;
+    return true;
+  }
+  case '*': {
+    int64_t len = std::strtoll(std::string(body).c_str(), nullptr, 10);
+    if (len < 0) {
+      reply->type = RespReply::Type::kNil;
+      return true;
+    }
+    reply->type = RespReply::Type::kArray;
+    reply->elements.resize(len);
+    for (RespReply &element : reply->elements) {
+      if (!ReadReply(&element)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  default:
+    last_error_ = "unexpected reply type";
+    return false;
+  }
+}
+
+}  // namespace eloqdb_bench
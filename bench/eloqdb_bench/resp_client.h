@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace eloqdb_bench {
+
+// Reply to a RESP command. Arrays keep their elements in `elements`.
+struct RespReply {
+  enum class Type { kStatus, kError, kInteger, kBulk, kNil, kArray };
+  Type type = Type::kNil;
+  std::string str;
+  int64_t integer = 0;
+  std::vector<RespReply> elements;
+
+  bool IsError() const { return type == Type::kError; }
+};
+
+// Minimal blocking RESP client with one connection, used by the KV workload
+// threads. Each thread owns its client, so no locking is done here.
+// A non-zero `timeout_ms` bounds connect, send and each wait for reply
+// bytes, so a node that stops answering fails the command instead of
+// blocking the thread forever.
+class RespClient {
+ public:
+  RespClient(std::string host, uint16_t port, int timeout_ms = 0);
+  ~RespClient();
+
+  RespClient(const RespClient &) = delete;
+  RespClient &operator=(const RespClient &) = delete;
+
+  bool Connect();
+  void Close();
+  bool Connected() const { return fd_ >= 0; }
+
+  // Sends one command and waits for its reply. Returns false and closes the
+  // connection on I/O or protocol errors; server errors are returned as a
+  // reply of type kError.
+  bool Command(const std::vector<std::string_view> &args, RespReply *reply);
+
+  const std::string &LastError() const { return last_error_; }
+
+ private:
+  bool Fill();
+  bool ReadLine(std::string_view *line);
+  bool ReadReply(RespReply *reply);
+
+  std::string host_;
+  uint16_t port_;
+  int timeout_ms_;
+  int fd_ = -1;
+  std::string out_;
+  std::string in_;
+  size_t in_pos_ = 0;
+  std::string last_error_;
+};
+
+}  // namespace eloqdb_bench
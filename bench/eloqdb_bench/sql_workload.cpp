@@ -0,0 +1,510 @@
+#include "sql_workload.h"
+
+#include <mysql.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace eloqdb_bench {
+
+namespace {
+
+constexpr int kDistrictsPerWarehouse = 10;
+constexpr int kLoadBatchRows = 500;
+
+std::string Sql(const char *fmt, ...) {
+  char buf[1024];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  return std::string(buf, std::min<size_t>(len, sizeof(buf) - 1));
+}
+
+class SqlConnection {
+ public:
+  SqlConnection(const SqlConfig &config, const Endpoint &endpoint)
+      : config_(config), endpoint_(endpoint) {}
+  ~SqlConnection() { Close(); }
+
+  SqlConnection(const SqlConnection &) = delete;
+  SqlConnection &operator=(const SqlConnection &) = delete;
+
+  bool Connect(bool use_database, bool autocommit) {
+    Close();
+    mysql_ = mysql_init(nullptr);
+    if (mysql_ == nullptr) {
+      error_ = "mysql_init failed";
+      return false;
+    }
+    if (config_.io_timeout_ms > 0) {
+      // The client library takes whole seconds. A timed-out read surfaces
+      // as CR_SERVER_LOST, which drops the connection like any other loss.
+      unsigned int seconds = (config_.io_timeout_ms + 999) / 1000;
+      mysql_options(mysql_, MYSQL_OPT_CONNECT_TIMEOUT, &seconds);
+      mysql_options(mysql_, MYSQL_OPT_READ_TIMEOUT, &seconds);
+      mysql_options(mysql_, MYSQL_OPT_WRITE_TIMEOUT, &seconds);
+    }
+    const char *db = use_database ? config_.database.c_str() : nullptr;
+    if (mysql_real_connect(mysql_, endpoint_.host.c_str(),
+                           config_.user.c_str(), config_.password.c_str(), db,
+                           endpoint_.port, nullptr, 0) == nullptr ||
+        mysql_autocommit(mysql_, autocommit) != 0) {
+      error_ = mysql_error(mysql_);
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close() {
+    if (mysql_ != nullptr) {
+      mysql_close(mysql_);
+      mysql_ = nullptr;
+    }
+  }
+
+  bool Connected() const { return mysql_ != nullptr; }
+
+  // Executes a statement and discards any result set.
+  bool Exec(const std::string &sql) {
+    errno_ = 0;
+    if (mysql_real_query(mysql_, sql.data(), sql.size()) != 0) {
+      return Failed();
+    }
+    MYSQL_RES *res = mysql_store_result(mysql_);
+    if (res != nullptr) {
+      mysql_free_result(res);
+    }
+    return true;
+  }
+
+  // Executes a query and returns the columns of its first row in `row`
+  // (empty if there are no rows).
+  bool QueryRow(const std::string &sql, std::vector<std::string> *row) {
+    row->clear();
+    errno_ = 0;
+    if (mysql_real_query(mysql_, sql.data(), sql.size()) != 0) {
+      return Failed();
+    }
+    MYSQL_RES *res = mysql_store_result(mysql_);
+    if (res == nullptr) {
+      return mysql_field_count(mysql_) == 0 || Failed();
+    }
+    if (MYSQL_ROW r = mysql_fetch_row(res)) {
+      unsigned int fields = mysql_num_fields(res);
+      for (unsigned int i = 0; i < fields; ++i) {
+        row->emplace_back(r[i] == nullptr ? "" : r[i]);
+      }
+    }
+    mysql_free_result(res);
+    return true;
+  }
+
+  unsigned int LastErrno() const { return errno_; }
+  const std::string &LastError() const { return error_; }
+
+ private:
+  bool Failed() {
+    errno_ = mysql_errno(mysql_);
+    error_ = mysql_error(mysql_);
+    return false;
+  }
+
+  const SqlConfig &config_;
+  const Endpoint &endpoint_;
+  MYSQL *mysql_ = nullptr;
+  unsigned int errno_ = 0;
+  std::string error_;
+};
+
+bool IsConflict(unsigned int err) {
+  // ER_LOCK_WAIT_TIMEOUT, ER_LOCK_DEADLOCK, ER_CHECKREAD (record changed
+  // since last read, reported on OCC validation failures).
+  return err == 1205 || err == 1213 || err == 1020;
+}
+
+bool IsConnectionLost(unsigned int err) {
+  // CR_SERVER_GONE_ERROR, CR_SERVER_LOST, CR_CONNECTION_ERROR,
+  // CR_CONN_HOST_ERROR.
+  return err == 2006 || err == 2013 || err == 2002 || err == 2003;
+}
+
+// Appends multi-row INSERTs of up to kLoadBatchRows rows, flushing each
+// full batch through the connection.
+class BatchInserter {
+ public:
+  BatchInserter(SqlConnection *conn, const char *table)
+      : conn_(conn), prefix_(std::string("INSERT INTO ") + table + " VALUES ") {}
+
+  bool Add(const std::string &row) {
+    sql_ += rows_ == 0 ? prefix_ : ",";
+    sql_ += row;
+    return ++rows_ < kLoadBatchRows || Flush();
+  }
+
+  bool Flush() {
+    if (rows_ == 0) {
+      return true;
+    }
+    bool ok = conn_->Exec(sql_);
+    sql_.clear();
+    rows_ = 0;
+    return ok;
+  }
+
+ private:
+  SqlConnection *conn_;
+  std::string prefix_;
+  std::string sql_;
+  int rows_ = 0;
+};
+
+std::string TableOptions(const SqlConfig &config) {
+  return config.engine.empty() ? "" : " ENGINE=" + config.engine;
+}
+
+bool CreateSchema(const SqlConfig &config, std::string *error) {
+  SqlConnection conn(config, config.endpoints[0]);
+  if (!conn.Connect(false, true)) {
+    *error = conn.LastError();
+    return false;
+  }
+  std::string opts = TableOptions(config);
+  const std::vector<std::string> ddl = {
+      "DROP DATABASE IF EXISTS " + config.database,
+      "CREATE DATABASE " + config.database,
+      "USE " + config.database,
+      "CREATE TABLE warehouse (w_id INT NOT NULL, w_name VARCHAR(10), "
+      "w_tax DECIMAL(4,4), w_ytd DECIMAL(12,2), PRIMARY KEY (w_id))" + opts,
+      "CREATE TABLE district (d_w_id INT NOT NULL, d_id INT NOT NULL, "
+      "d_name VARCHAR(10), d_tax DECIMAL(4,4), d_ytd DECIMAL(12,2), "
+      "d_next_o_id INT, PRIMARY KEY (d_w_id, d_id))" + opts,
+      "CREATE TABLE customer (c_w_id INT NOT NULL, c_d_id INT NOT NULL, "
+      "c_id INT NOT NULL, c_last VARCHAR(16), c_discount DECIMAL(4,4), "
+      "c_balance DECIMAL(12,2), c_ytd_payment DECIMAL(12,2), "
+      "c_payment_cnt INT, c_data VARCHAR(250), "
+      "PRIMARY KEY (c_w_id, c_d_id, c_id))" + opts,
+      "CREATE TABLE item (i_id INT NOT NULL, i_name VARCHAR(24), "
+      "i_price DECIMAL(5,2), i_data VARCHAR(50), PRIMARY KEY (i_id))" + opts,
+      "CREATE TABLE stock (s_w_id INT NOT NULL, s_i_id INT NOT NULL, "
+      "s_quantity INT, s_ytd INT, s_order_cnt INT, s_data VARCHAR(50), "
+      "PRIMARY KEY (s_w_id, s_i_id))" + opts,
+      "CREATE TABLE orders (o_w_id INT NOT NULL, o_d_id INT NOT NULL, "
+      "o_id INT NOT NULL, o_c_id INT, o_entry_d DATETIME, o_ol_cnt INT, "
+      "PRIMARY KEY (o_w_id, o_d_id, o_id), "
+      "KEY idx_orders_customer (o_w_id, o_d_id, o_c_id, o_id))" + opts,
+      "CREATE TABLE order_line (ol_w_id INT NOT NULL, ol_d_id INT NOT NULL, "
+      "ol_o_id INT NOT NULL, ol_number INT NOT NULL, ol_i_id INT, "
+      "ol_supply_w_id INT, ol_quantity INT, ol_amount DECIMAL(6,2), "
+      "PRIMARY KEY (ol_w_id, ol_d_id, ol_o_id, ol_number))" + opts,
+  };
+  for (const std::string &stmt : ddl) {
+    if (!conn.Exec(stmt)) {
+      *error = stmt + ": " + conn.LastError();
+      return false;
+    }
+  }
+  return true;
+}
+
+using LoadTask = std::function<bool(SqlConnection *)>;
+
+std::vector<LoadTask> LoadTasks(const SqlConfig &config) {
+  std::vector<LoadTask> tasks;
+  const int chunk = 10000;
+  for (int first = 1; first <= config.items; first += chunk) {
+    int last = std::min(config.items, first + chunk - 1);
+    tasks.push_back([first, last](SqlConnection *conn) {
+      BatchInserter item(conn, "item");
+      for (int i = first; i <= last; ++i) {
+        if (!item.Add(Sql("(%d,'item%d',%d.%02d,'data')", i, i,
+                          1 + i % 100, i % 100))) {
+          return false;
+        }
+      }
+      return item.Flush();
+    });
+  }
+  for (int w = 1; w <= config.warehouses; ++w) {
+    tasks.push_back([w](SqlConnection *conn) {
+      if (!conn->Exec(Sql("INSERT INTO warehouse VALUES "
+                          "(%d,'wh%d',0.%04d,300000.00)",
+                          w, w, w * 37 % 2000))) {
+        return false;
+      }
+      BatchInserter district(conn, "district");
+      for (int d = 1; d <= kDistrictsPerWarehouse; ++d) {
+        if (!district.Add(Sql("(%d,%d,'dist%d',0.%04d,30000.00,1)", w, d, d,
+                              d * 53 % 2000))) {
+          return false;
+        }
+      }
+      return district.Flush();
+    });
+    for (int first = 1; first <= config.items; first += chunk) {
+      int last = std::min(config.items, first + chunk - 1);
+      tasks.push_back([w, first, last](SqlConnection *conn) {
+        BatchInserter stock(conn, "stock");
+        for (int i = first; i <= last; ++i) {
+          if (!stock.Add(Sql("(%d,%d,%d,0,0,'stockdata')", w, i,
+                             10 + i % 91))) {
+            return false;
+          }
+        }
+        return stock.Flush();
+      });
+    }
+    for (int d = 1; d <= kDistrictsPerWarehouse; ++d) {
+      int customers = config.customers_per_district;
+      tasks.push_back([w, d, customers](SqlConnection *conn) {
+        BatchInserter customer(conn, "customer");
+        for (int c = 1; c <= customers; ++c) {
+          if (!customer.Add(Sql("(%d,%d,%d,'last%d',0.%04d,-10.00,10.00,1,"
+                                "'customerdata')",
+                                w, d, c, c % 1000, c * 29 % 5000))) {
+            return false;
+          }
+        }
+        return customer.Flush();
+      });
+    }
+  }
+  return tasks;
+}
+
+class SqlWorkload : public Workload {
+ public:
+  SqlWorkload(const SqlConfig &config, int thread_index, uint64_t seed)
+      : config_(config),
+        conn_(config, config.endpoints[thread_index % config.endpoints.size()]),
+        home_w_(thread_index % config.warehouses + 1),
+        rng_(seed) {}
+
+  OpResult RunOne() override {
+    if (!conn_.Connected() && !conn_.Connect(true, false)) {
+      // Back off so an unreachable server does not turn into a busy loop.
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      return {"sql.connect", OpStatus::kError};
+    }
+    int total = config_.new_order_weight + config_.payment_weight +
+                config_.order_status_weight;
+    int pick = Uniform(1, total);
+    if (pick <= config_.new_order_weight) {
+      return Finish("sql.new_order", NewOrder());
+    }
+    if (pick <= config_.new_order_weight + config_.payment_weight) {
+      return Finish("sql.payment", Payment());
+    }
+    return Finish("sql.order_status", OrderStatus());
+  }
+
+ private:
+  int Uniform(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng_);
+  }
+
+  // TPC-C non-uniform random, clause 2.1.6, with a fixed C.
+  int NURand(int a, int x, int y) {
+    return (((Uniform(0, a) | Uniform(x, y)) + 42) % (y - x + 1)) + x;
+  }
+
+  OpResult Finish(const char *op, bool ok) {
+    if (ok) {
+      return {op, OpStatus::kOk};
+    }
+    unsigned int err = conn_.LastErrno();
+    if (IsConnectionLost(err)) {
+      conn_.Close();
+      return {op, OpStatus::kError};
+    }
+    conn_.Exec("ROLLBACK");
+    return {op, IsConflict(err) ? OpStatus::kAbort : OpStatus::kError};
+  }
+
+  bool NewOrder() {
+    int w = home_w_;
+    int d = Uniform(1, kDistrictsPerWarehouse);
+    int c = NURand(1023, 1, config_.customers_per_district);
+    int ol_cnt = Uniform(5, 15);
+
+    if (!conn_.QueryRow(Sql("SELECT w_tax FROM warehouse WHERE w_id=%d", w),
+                        &row_) ||
+        !conn_.QueryRow(Sql("SELECT d_tax, d_next_o_id FROM district "
+                            "WHERE d_w_id=%d AND d_id=%d FOR UPDATE",
+                            w, d),
+                        &row_) ||
+        row_.size() < 2) {
+      return false;
+    }
+    int o_id = std::atoi(row_[1].c_str());
+    if (!conn_.Exec(Sql("UPDATE district SET d_next_o_id=%d "
+                        "WHERE d_w_id=%d AND d_id=%d",
+                        o_id + 1, w, d)) ||
+        !conn_.QueryRow(Sql("SELECT c_discount, c_last FROM customer "
+                            "WHERE c_w_id=%d AND c_d_id=%d AND c_id=%d",
+                            w, d, c),
+                        &row_) ||
+        !conn_.Exec(Sql("INSERT INTO orders VALUES (%d,%d,%d,%d,NOW(),%d)", w,
+                        d, o_id, c, ol_cnt))) {
+      return false;
+    }
+    for (int ol = 1; ol <= ol_cnt; ++ol) {
+      int item = NURand(8191, 1, config_.items);
+      int supply_w = w;
+      if (config_.warehouses > 1 && Uniform(1, 100) == 1) {
+        supply_w = Uniform(1, config_.warehouses - 1);
+        supply_w += supply_w >= w ? 1 : 0;
+      }
+      int qty = Uniform(1, 10);
+      if (!conn_.QueryRow(Sql("SELECT i_price FROM item WHERE i_id=%d", item),
+                          &row_) ||
+          row_.empty()) {
+        return false;
+      }
+      double amount = qty * std::strtod(row_[0].c_str(), nullptr);
+      if (!conn_.QueryRow(Sql("SELECT s_quantity FROM stock "
+                              "WHERE s_w_id=%d AND s_i_id=%d FOR UPDATE",
+                              supply_w, item),
+                          &row_) ||
+          row_.empty()) {
+        return false;
+      }
+      int s_qty = std::atoi(row_[0].c_str());
+      s_qty = s_qty >= qty + 10 ? s_qty - qty : s_qty - qty + 91;
+      if (!conn_.Exec(Sql("UPDATE stock SET s_quantity=%d, s_ytd=s_ytd+%d, "
+                          "s_order_cnt=s_order_cnt+1 "
+                          "WHERE s_w_id=%d AND s_i_id=%d",
+                          s_qty, qty, supply_w, item)) ||
+          !conn_.Exec(Sql("INSERT INTO order_line VALUES "
+                          "(%d,%d,%d,%d,%d,%d,%d,%.2f)",
+                          w, d, o_id, ol, item, supply_w, qty, amount))) {
+        return false;
+      }
+    }
+    return conn_.Exec("COMMIT");
+  }
+
+  bool Payment() {
+    int w = home_w_;
+    int d = Uniform(1, kDistrictsPerWarehouse);
+    int c = NURand(1023, 1, config_.customers_per_district);
+    double amount = Uniform(100, 500000) / 100.0;
+    return conn_.Exec(Sql("UPDATE warehouse SET w_ytd=w_ytd+%.2f "
+                          "WHERE w_id=%d",
+                          amount, w)) &&
+           conn_.Exec(Sql("UPDATE district SET d_ytd=d_ytd+%.2f "
+                          "WHERE d_w_id=%d AND d_id=%d",
+                          amount, w, d)) &&
+           conn_.Exec(Sql("UPDATE customer SET c_balance=c_balance-%.2f, "
+                          "c_ytd_payment=c_ytd_payment+%.2f, "
+                          "c_payment_cnt=c_payment_cnt+1 "
+                          "WHERE c_w_id=%d AND c_d_id=%d AND c_id=%d",
+                          amount, amount, w, d, c)) &&
+           conn_.Exec("COMMIT");
+  }
+
+  bool OrderStatus() {
+    int w = home_w_;
+    int d = Uniform(1, kDistrictsPerWarehouse);
+    int c = NURand(1023, 1, config_.customers_per_district);
+    if (!conn_.QueryRow(Sql("SELECT c_balance, c_last FROM customer "
+                            "WHERE c_w_id=%d AND c_d_id=%d AND c_id=%d",
+                            w, d, c),
+                        &row_) ||
+        !conn_.QueryRow(Sql("SELECT o_id, o_entry_d, o_ol_cnt FROM orders "
+                            "WHERE o_w_id=%d AND o_d_id=%d AND o_c_id=%d "
+                            "ORDER BY o_id DESC LIMIT 1",
+                            w, d, c),
+                        &row_)) {
+      return false;
+    }
+    if (!row_.empty() &&
+        !conn_.Exec(Sql("SELECT ol_i_id, ol_quantity, ol_amount "
+                        "FROM order_line "
+                        "WHERE ol_w_id=%d AND ol_d_id=%d AND ol_o_id=%s",
+                        w, d, row_[0].c_str()))) {
+      return false;
+    }
+    return conn_.Exec("COMMIT");
+  }
+
+  const SqlConfig &config_;
+  SqlConnection conn_;
+  int home_w_;
+  std::mt19937_64 rng_;
+  std::vector<std::string> row_;
+};
+
+}  // namespace
+
+bool ParseSqlMix(const std::string &mix, SqlConfig *config) {
+  std::vector<int> weights;
+  std::stringstream ss(mix);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    weights.push_back(std::atoi(item.c_str()));
+  }
+  if (weights.size() != 3 ||
+      std::any_of(weights.begin(), weights.end(), [](int w) { return w < 0; }) ||
+      weights[0] + weights[1] + weights[2] == 0) {
+    return false;
+  }
+  config->new_order_weight = weights[0];
+  config->payment_weight = weights[1];
+  config->order_status_weight = weights[2];
+  return true;
+}
+
+bool LoadSql(const SqlConfig &config, int threads, std::string *error) {
+  if (!CreateSchema(config, error)) {
+    return false;
+  }
+  std::vector<LoadTask> tasks = LoadTasks(config);
+  std::atomic<size_t> next_task{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::string> errors(threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      SqlConnection conn(config, config.endpoints[t % config.endpoints.size()]);
+      if (!conn.Connect(true, true)) {
+        errors[t] = conn.LastError();
+        failed = true;
+        return;
+      }
+      for (size_t i = next_task++; i < tasks.size() && !failed;
+           i = next_task++) {
+        if (!tasks[i](&conn)) {
+          errors[t] = conn.LastError();
+          failed = true;
+        }
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  for (const std::string &err : errors) {
+    if (!err.empty()) {
+      *error = err;
+      break;
+    }
+  }
+  return !failed;
+}
+
+std::unique_ptr<Workload> NewSqlWorkload(const SqlConfig &config,
+                                         int thread_index, uint64_t seed) {
+  return std::make_unique<SqlWorkload>(config, thread_index, seed);
+}
+
+}  // namespace eloqdb_bench
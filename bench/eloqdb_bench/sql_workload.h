@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+
+namespace eloqdb_bench {
+
+// TPC-C-like transactional workload over the MySQL protocol. It keeps the
+// TPC-C schema shape and the NewOrder / Payment / OrderStatus transactions
+// but drops the rest of the spec (history, delivery, stock level, think
+// times), so numbers are comparable between eloqdb builds, not tpmC.
+struct SqlConfig {
+  std::vector<Endpoint> endpoints;
+  std::string user = "root";
+  std::string password;
+  std::string database = "eloqdb_bench";
+  // Storage engine for CREATE TABLE; empty uses the server default.
+  std::string engine;
+  int warehouses = 1;
+  int items = 100000;
+  int customers_per_district = 3000;
+  // Relative weights of NewOrder, Payment and OrderStatus.
+  int new_order_weight = 45;
+  int payment_weight = 43;
+  int order_status_weight = 12;
+  // Connect, read and write timeout; 0 keeps the client library defaults.
+  int io_timeout_ms = 0;
+};
+
+// Parses "new_order,payment,order_status" weights, e.g. "45,43,12".
+bool ParseSqlMix(const std::string &mix, SqlConfig *config);
+
+// Creates the schema and populates warehouses with `threads` connections.
+bool LoadSql(const SqlConfig &config, int threads, std::string *error);
+
+std::unique_ptr<Workload> NewSqlWorkload(const SqlConfig &config,
+                                         int thread_index, uint64_t seed);
+
+}  // namespace eloqdb_bench
@@ -0,0 +1,30 @@
+#include "workload.h"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace eloqdb_bench {
+
+bool ParseEndpoints(const std::string &list, std::vector<Endpoint> *endpoints) {
+  endpoints->clear();
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty()) {
+      continue;
+    }
+    size_t colon = item.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+      return false;
+    }
+    char *end = nullptr;
+    long port = std::strtol(item.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || port <= 0 || port > 65535) {
+      return false;
+    }
+    endpoints->push_back({item.substr(0, colon), static_cast<uint16_t>(port)});
+  }
+  return !endpoints->empty();
+}
+
+}  // namespace eloqdb_bench
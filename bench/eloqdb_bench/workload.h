@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eloqdb_bench {
+
+enum class OpStatus {
+  kOk,
+  // The server rejected the operation as a transaction conflict; counted
+  // separately from errors because OCC aborts are expected under contention.
+  kAbort,
+  kError,
+};
+
+struct OpResult {
+  // Static operation name, "<engine>.<op>", e.g. "kv.read" or
+  // "sql.new_order". The prefix selects the engine in the report.
+  const char *op;
+  OpStatus status;
+};
+
+// One client session of a workload. Every driver thread owns one instance
+// and calls RunOne() in a loop; the driver does the timing.
+class Workload {
+ public:
+  virtual ~Workload() = default;
+  virtual OpResult RunOne() = 0;
+};
+
+struct Endpoint {
+  std::string host;
+  uint16_t port = 0;
+};
+
+// Parses a comma-separated "host:port" list.
+bool ParseEndpoints(const std::string &list, std::vector<Endpoint> *endpoints);
+
+// 64-bit FNV-1a, used to scatter sequential key numbers the way YCSB does.
+inline uint64_t FnvHash64(uint64_t value) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; ++i) {
+    hash ^= value & 0xff;
+    hash *= 0x100000001b3ULL;
+    value >>= 8;
+  }
+  return hash;
+}
+
+}  // namespace eloqdb_bench
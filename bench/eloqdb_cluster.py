@@ -0,0 +1,445 @@
+"""Launch and control a local multi-node eloqdb cluster.
+
+Every node is a separate eloqdb process on 127.0.0.1 with its own
+ds.cnf generated from conf/ds.cnf (distinct tx_port, eloq_data_path and a
+shared tx_ip_port_list) and, when EloqSQL is built in, its own EloqSQL
+config generated from conf/eloqsql.cnf. An optional MinIO process stands
+in for S3.
+
+With EloqSQL, each node's datadir is initialized on its first start by
+running the sql_install_db command (mysql_install_db by default), since
+mysqld cannot start on an empty datadir. Host-specific paths in the
+templates, such as lc_messages_dir in eloqsql.cnf, are replaced with
+sql_overrides / ds_overrides (--sql-set / --set in the scripts).
+
+Used by cluster_harness.py and the other scripts in this directory; it
+only depends on the Python standard library.
+"""
+
+import os
+import shlex
+import shutil
+import signal
+import socket
+import subprocess
+import time
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_DS_TEMPLATE = os.path.join(REPO_ROOT, "conf", "ds.cnf")
+DEFAULT_SQL_TEMPLATE = os.path.join(REPO_ROOT, "conf", "eloqsql.cnf")
+# {defaults_file} and {datadir} are substituted. Root gets password login
+# so eloqdb_bench can connect over TCP.
+DEFAULT_SQL_INSTALL_DB = ("mysql_install_db --defaults-file={defaults_file} "
+                          "--datadir={datadir} "
+                          "--auth-root-authentication-method=normal")
+
+
+def rewrite_cnf(text, overrides):
+    """Return `text` with `overrides` ({section: {key: value}}) applied.
+
+    Comments and key order of the template are kept; keys missing from a
+    section are added after its last key, missing sections are appended.
+    """
+    out = []
+    section = None
+    last_line = {}
+    replaced = set()
+    for line in text.splitlines():
+        stripped = line.strip()
+        if stripped.startswith("[") and stripped.endswith("]"):
+            section = stripped[1:-1]
+            last_line[section] = len(out)
+        elif stripped and not stripped.startswith("#") and "=" in stripped:
+            key = stripped.split("=", 1)[0].strip()
+            values = overrides.get(section, {})
+            if key in values:
+                line = "%s=%s" % (key, values[key])
+                replaced.add((section, key))
+            last_line[section] = len(out)
+        out.append(line)
+
+    inserts = []
+    for sec, values in overrides.items():
+        missing = ["%s=%s" % (k, v) for k, v in values.items()
+                   if (sec, k) not in replaced]
+        if not missing:
+            continue
+        if sec in last_line:
+            inserts.append((last_line[sec] + 1, missing))
+        else:
+            out += ["[%s]" % sec] + missing
+    for pos, lines in sorted(inserts, reverse=True):
+        out[pos:pos] = lines
+    return "\n".join(out) + "\n"
+
+
+def parse_overrides(items, default_section):
+    """Parse [SECTION.]KEY=VALUE items into {section: {key: value}}."""
+    overrides = {}
+    for item in items:
+        key, _, value = item.partition("=")
+        section, _, key = key.rpartition(".")
+        overrides.setdefault(section or default_section, {})[key] = value
+    return overrides
+
+
+def add_sql_arguments(parser):
+    """Add the EloqSQL datadir and config options shared by the scripts."""
+    parser.add_argument("--sql-set", action="append", default=[],
+                        metavar="[SECTION.]KEY=VALUE",
+                        help="override an eloqsql.cnf key on every node "
+                        "(default section: mariadb), e.g. "
+                        "lc_messages_dir=/opt/eloqsql/share")
+    parser.add_argument("--sql-install-db", default=DEFAULT_SQL_INSTALL_DB,
+                        metavar="CMD",
+                        help="shell command that initializes a node's "
+                        "EloqSQL datadir before its first start; "
+                        "{defaults_file} and {datadir} are substituted, an "
+                        "empty CMD skips it (default: %(default)s)")
+
+
+def wait_for_port(host, port, timeout):
+    """Wait until a TCP connect to host:port succeeds; return the seconds
+    waited, or None on timeout."""
+    start = time.monotonic()
+    while time.monotonic() - start < timeout:
+        try:
+            with socket.create_connection((host, port), timeout=0.5):
+                return time.monotonic() - start
+        except OSError:
+            time.sleep(0.05)
+    return None
+
+
+class RespError(RuntimeError):
+    """Error reply from the server."""
+
+
+class RespConnection:
+    """Blocking RESP (Redis protocol) connection.
+
+    call() sends one command and returns its reply; pipeline() sends a
+    batch in one write and returns the replies in order. Replies are bytes
+    for status and bulk strings, int, None for nil, or lists; error
+    replies raise RespError. Arguments may be bytes, str or numbers.
+    """
+
+    def __init__(self, host, port, timeout=5.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.file = self.sock.makefile("rb")
+
+    def close(self):
+        self.file.close()
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    @staticmethod
+    def encode(args):
+        out = [b"*%d\r\n" % len(args)]
+        for arg in args:
+            if not isinstance(arg, bytes):
+                arg = str(arg).encode()
+            out.append(b"$%d\r\n%s\r\n" % (len(arg), arg))
+        return b"".join(out)
+
+    def read_reply(self):
+        line = self.file.readline()
+        if not line.endswith(b"\r\n"):
+            raise ConnectionError("connection closed")
+        kind, body = line[:1], line[1:-2]
+        if kind == b"+":
+            return body
+        if kind == b"-":
+            raise RespError(body.decode(errors="replace"))
+        if kind == b":":
+            return int(body)
+        if kind == b"$":
+            if int(body) < 0:
+                return None
+            data = self.file.read(int(body) + 2)
+            if len(data) != int(body) + 2:
+                raise ConnectionError("connection closed")
+            return data[:-2]
+        if kind == b"*":
+            if int(body) < 0:
+                return None
+            return [self.read_reply() for _ in range(int(body))]
+        raise ValueError("bad RESP reply %r" % line)
+
+    def call(self, *args):
+        self.sock.sendall(self.encode(args))
+        return self.read_reply()
+
+    def pipeline(self, commands):
+        self.sock.sendall(b"".join(self.encode(c) for c in commands))
+        return [self.read_reply() for _ in commands]
+
+
+class Node:
+    def __init__(self, cluster, index):
+        self.cluster = cluster
+        self.index = index
+        self.host = "127.0.0.1"
+        self.tx_port = cluster.base_port + index * cluster.port_step
+        self.kv_port = self.tx_port + cluster.kv_port_offset
+        self.sql_port = cluster.sql_base_port + index
+        self.dir = os.path.join(cluster.workdir, "node%d" % index)
+        self.data_path = os.path.join(self.dir, "data")
+        self.ds_cnf = os.path.join(self.dir, "ds.cnf")
+        self.sql_cnf = os.path.join(self.dir, "eloqsql.cnf")
+        self.log_path = os.path.join(self.dir, "eloqdb.out")
+        self.proc = None
+        self.log_file = None
+
+    @property
+    def address(self):
+        return "%s:%d" % (self.host, self.tx_port)
+
+    def write_config(self, ds_overrides=None):
+        os.makedirs(self.data_path, exist_ok=True)
+        local = {
+            "tx_ip": self.host,
+            "tx_port": self.tx_port,
+            "eloq_data_path": self.data_path,
+        }
+        if self.cluster.s3_endpoint:
+            local["txlog_rocksdb_cloud_endpoint_url"] = self.cluster.s3_endpoint
+        local.update(self.cluster.ds_overrides.get("local", {}))
+        overrides = dict(self.cluster.ds_overrides)
+        overrides["local"] = local
+        overrides["cluster"] = {
+            "tx_ip_port_list": ",".join(n.address for n in self.cluster.nodes)
+        }
+        for sec, kv in (ds_overrides or {}).items():
+            overrides.setdefault(sec, {}).update(kv)
+        with open(self.cluster.ds_template) as f:
+            text = rewrite_cnf(f.read(), overrides)
+        with open(self.ds_cnf, "w") as f:
+            f.write(text)
+
+        if self.cluster.with_sql:
+            sql = {sec: dict(kv)
+                   for sec, kv in self.cluster.sql_overrides.items()}
+            sql.setdefault("mariadb", {}).update({
+                "datadir": self.data_path,
+                "port": self.sql_port,
+                "socket": os.path.join(self.dir, "mysqld.sock"),
+            })
+            with open(self.cluster.sql_template) as f:
+                text = rewrite_cnf(f.read(), sql)
+            with open(self.sql_cnf, "w") as f:
+                f.write(text)
+
+    def init_sql_datadir(self):
+        """Run the cluster's sql_install_db command once per datadir."""
+        if (not self.cluster.sql_install_db or
+                os.path.isdir(os.path.join(self.data_path, "mysql"))):
+            return
+        cmd = self.cluster.sql_install_db.format(
+            defaults_file=shlex.quote(self.sql_cnf),
+            datadir=shlex.quote(self.data_path))
+        log_path = os.path.join(self.dir, "install_db.out")
+        with open(log_path, "ab") as log:
+            rc = subprocess.run(cmd, shell=True, cwd=self.dir, stdout=log,
+                                stderr=subprocess.STDOUT).returncode
+        if rc != 0:
+            raise RuntimeError("initializing the EloqSQL datadir of node %d "
+                               "failed with status %d, see %s (set the "
+                               "command with --sql-install-db)"
+                               % (self.index, rc, log_path))
+
+    def start(self):
+        args = [self.cluster.eloqdb, "--config=%s" % self.ds_cnf]
+        if self.cluster.with_sql:
+            self.init_sql_datadir()
+            args.append("--eloqsql_config=%s" % self.sql_cnf)
+        args += ["--log_dir=%s" % os.path.join(self.dir, "logs")]
+        self.log_file = open(self.log_path, "ab")
+        self.proc = subprocess.Popen(
+            args,
+            cwd=self.dir,
+            stdout=self.log_file,
+            stderr=subprocess.STDOUT,
+            start_new_session=True,
+        )
+        return self.proc
+
+    def alive(self):
+        return self.proc is not None and self.proc.poll() is None
+
+    def send_signal(self, sig):
+        if self.alive():
+            os.kill(self.proc.pid, sig)
+
+    def stop(self, sig=signal.SIGTERM, timeout=60):
+        """Stop the node with `sig` and return its exit code."""
+        if not self.alive():
+            return None if self.proc is None else self.proc.returncode
+        self.send_signal(sig)
+        try:
+            self.proc.wait(timeout=timeout)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+            self.proc.wait()
+        if self.log_file:
+            self.log_file.close()
+            self.log_file = None
+        return self.proc.returncode
+
+    def wait_ready(self, timeout):
+        """Wait until the node answers PING on its KV port; return seconds
+        waited or None."""
+        start = time.monotonic()
+        while time.monotonic() - start < timeout:
+            if not self.alive():
+                return None
+            try:
+                with RespConnection(self.host, self.kv_port,
+                                    timeout=2.0) as conn:
+                    if conn.call("PING") == b"PONG":
+                        return time.monotonic() - start
+            except (OSError, RespError, ValueError):
+                pass
+            time.sleep(0.05)
+        return None
+
+
+class Cluster:
+    def __init__(self, eloqdb, workdir, nodes=3, base_port=6389, port_step=10,
+                 kv_port_offset=0, sql_base_port=3317, with_sql=False,
+                 ds_template=DEFAULT_DS_TEMPLATE,
+                 sql_template=DEFAULT_SQL_TEMPLATE, s3_endpoint=None,
+                 minio=None, minio_port=9000, ds_overrides=None,
+                 sql_overrides=None, sql_install_db=DEFAULT_SQL_INSTALL_DB):
+        self.eloqdb = os.path.abspath(eloqdb)
+        self.workdir = os.path.abspath(workdir)
+        self.base_port = base_port
+        self.port_step = port_step
+        self.kv_port_offset = kv_port_offset
+        self.sql_base_port = sql_base_port
+        self.with_sql = with_sql
+        self.ds_template = ds_template
+        self.sql_template = sql_template
+        self.ds_overrides = ds_overrides or {}
+        self.sql_overrides = sql_overrides or {}
+        self.sql_install_db = sql_install_db
+        self.minio = minio
+        self.minio_port = minio_port
+        self.minio_proc = None
+        self.s3_endpoint = s3_endpoint
+        if minio and not s3_endpoint:
+            self.s3_endpoint = "http://127.0.0.1:%d" % minio_port
+        self.nodes = [Node(self, i) for i in range(nodes)]
+
+    def kv_endpoints(self, nodes=None):
+        """Comma-separated host:port list of the nodes' KV (RESP) ports."""
+        return ",".join("%s:%d" % (n.host, n.kv_port)
+                        for n in (self.nodes if nodes is None else nodes))
+
+    def sql_endpoints(self, nodes=None):
+        """Comma-separated host:port list of the nodes' MySQL ports."""
+        return ",".join("%s:%d" % (n.host, n.sql_port)
+                        for n in (self.nodes if nodes is None else nodes))
+
+    def format_command(self, template):
+        """Substitute {kv_endpoints} and {sql_endpoints} in `template`."""
+        return template.format(kv_endpoints=self.kv_endpoints(),
+                               sql_endpoints=self.sql_endpoints())
+
+    def add_node(self):
+        """Append a node to the cluster (not started); every node's config
+        is regenerated so tx_ip_port_list stays consistent."""
+        node = Node(self, len(self.nodes))
+        self.nodes.append(node)
+        for n in self.nodes:
+            n.write_config()
+        return node
+
+    def start_s3(self, timeout=30):
+        if not self.minio:
+            return
+        s3_dir = os.path.join(self.workdir, "s3")
+        os.makedirs(s3_dir, exist_ok=True)
+        env = dict(os.environ)
+        env.setdefault("MINIO_ROOT_USER", "minioadmin")
+        env.setdefault("MINIO_ROOT_PASSWORD", "minioadmin")
+        log = open(os.path.join(self.workdir, "minio.out"), "ab")
+        self.minio_proc = subprocess.Popen(
+            [self.minio, "server", s3_dir,
+             "--address", "127.0.0.1:%d" % self.minio_port],
+            stdout=log, stderr=subprocess.STDOUT, env=env,
+            start_new_session=True)
+        if wait_for_port("127.0.0.1", self.minio_port, timeout) is None:
+            raise RuntimeError("S3 stand-in did not come up on port %d"
+                               % self.minio_port)
+
+    def start(self, ready_timeout=600, clean=True):
+        """Generate configs, start S3 and all nodes; return a dict of
+        node index -> seconds until the node answered."""
+        if clean and os.path.isdir(self.workdir):
+            shutil.rmtree(self.workdir)
+        os.makedirs(self.workdir, exist_ok=True)
+        self.start_s3()
+        for node in self.nodes:
+            node.write_config()
+        for node in self.nodes:
+            node.start()
+        ready = {}
+        for node in self.nodes:
+            waited = node.wait_ready(ready_timeout)
+            if waited is None:
+                raise RuntimeError("node %d did not become ready, see %s"
+                                   % (node.index, node.log_path))
+            ready[node.index] = waited
+        return ready
+
+    def stop(self, sig=signal.SIGTERM):
+        for node in self.nodes:
+            node.stop(sig)
+        if self.minio_proc and self.minio_proc.poll() is None:
+            self.minio_proc.terminate()
+            self.minio_proc.wait()
+        self.minio_proc = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.stop()
+        return False
+
+
+class NetworkDelay:
+    """Add latency to loopback traffic with tc/netem (requires root).
+
+    All nodes share the loopback device, so the delay applies to traffic
+    between every node and to client traffic alike.
+    """
+
+    def __init__(self, delay_ms, jitter_ms=0, device="lo"):
+        self.delay_ms = delay_ms
+        self.jitter_ms = jitter_ms
+        self.device = device
+        self.active = False
+
+    def __enter__(self):
+        cmd = ["tc", "qdisc", "add", "dev", self.device, "root", "netem",
+               "delay", "%dms" % self.delay_ms]
+        if self.jitter_ms:
+            cmd.append("%dms" % self.jitter_ms)
+        subprocess.run(cmd, check=True)
+        self.active = True
+        return self
+
+    def __exit__(self, *exc):
+        if self.active:
+            subprocess.run(["tc", "qdisc", "del", "dev", self.device, "root"],
+                           check=False)
+            self.active = False
+        return False
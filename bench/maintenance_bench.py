@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""Latency-under-maintenance benchmark for eloqdb.
+
+Runs eloqdb_bench open-loop at a constant rate (latency is measured from
+each request's scheduled start, so stalls are not hidden by coordinated
+omission) against a fresh local cluster per scenario, and compares each
+scenario's latency distribution with the baseline:
+
+  baseline    checkpoints pushed out of the measured window
+  checkpoint  short checkpoint_interval, so dirty data is flushed and the
+              log truncated repeatedly while the workload runs
+  eviction    node_memory_limit_mb well below the dataset with uniform
+              key access, so the cache evicts continuously
+  restart     SIGKILL and restart a peer node mid-run (recovery and
+              ownership failover); needs --nodes >= 2
+  NAME=CMD    (--trigger, repeatable) run shell command CMD at
+              --trigger-at, e.g. to start a rebalance; "{kv_endpoints}"
+              and "{sql_endpoints}" are substituted
+
+Choose rates well below the closed-loop peak of the baseline (e.g. 50-70%)
+so the baseline itself is not queueing. The report holds each scenario's
+percentiles and their ratio to the baseline, plus per-second throughput
+and worst latency to line spikes up with the background operation.
+"""
+
+import argparse
+import json
+import os
+import signal
+import subprocess
+import sys
+import threading
+import time
+
+import eloqdb_cluster
+
+PERCENTILES = ("p50", "p90", "p99", "p999", "max")
+
+
+def scenario_overrides(args, name):
+    local = {"checkpoint_interval": args.baseline_checkpoint_interval}
+    if name == "checkpoint":
+        local["checkpoint_interval"] = args.checkpoint_interval
+    elif name == "eviction":
+        local["node_memory_limit_mb"] = args.eviction_memory_mb
+    return {"local": local}
+
+
+def bench_command(args, cluster, name, extra):
+    kv_nodes = cluster.nodes
+    if args.restart_node is not None:
+        kv_nodes = [n for n in cluster.nodes if n.index != args.restart_node]
+    cmd = [
+        args.eloqdb_bench,
+        "--kv_endpoints=" + cluster.kv_endpoints(kv_nodes),
+        "--sql_endpoints=" + cluster.sql_endpoints(kv_nodes),
+        "--kv_threads=%d" % args.kv_threads,
+        "--record_count=%d" % args.records,
+        "--ycsb_workload=" + args.ycsb_workload,
+    ]
+    if name == "eviction":
+        # A zipfian hot set can fit in the reduced cache and hide eviction;
+        # uniform access keeps the whole dataset in play.
+        cmd.append("--request_distribution=uniform")
+    # Without --sql-threads eloqdb_bench picks its own default, which is 0
+    # when it was built without a MySQL client library.
+    if not args.with_sql:
+        cmd.append("--sql_threads=0")
+    elif args.sql_threads is not None:
+        cmd.append("--sql_threads=%d" % args.sql_threads)
+    return cmd + args.bench_arg + extra
+
+
+def run_scenario(args, name, trigger_cmd=None):
+    workdir = os.path.join(args.workdir, name)
+    cluster = eloqdb_cluster.Cluster(
+        args.eloqdb, workdir, nodes=args.nodes, base_port=args.base_port,
+        kv_port_offset=args.kv_port_offset, with_sql=args.with_sql,
+        s3_endpoint=args.s3_endpoint, minio=args.minio,
+        ds_overrides=scenario_overrides(args, name),
+        sql_overrides=eloqdb_cluster.parse_overrides(args.sql_set, "mariadb"),
+        sql_install_db=args.sql_install_db)
+    report_path = os.path.join(args.workdir, name + ".bench.json")
+    with cluster:
+        cluster.start(ready_timeout=args.ready_timeout)
+        subprocess.run(bench_command(args, cluster, name,
+                                     ["--load", "--run=false"]),
+                       check=True)
+
+        run_cmd = bench_command(args, cluster, name, [
+            "--kv_rate=%g" % args.kv_rate,
+            "--sql_rate=%g" % args.sql_rate,
+            "--warmup=%g" % args.warmup,
+            "--duration=%g" % args.duration,
+            "--label=" + name,
+            "--json_output=" + report_path,
+        ])
+        bench = subprocess.Popen(run_cmd, stdout=subprocess.DEVNULL)
+
+        trigger_log = {}
+
+        def trigger():
+            # Trigger times are relative to the start of measurement.
+            time.sleep(args.warmup + args.trigger_at)
+            trigger_log["at_s"] = args.trigger_at
+            if name == "restart":
+                node = cluster.nodes[args.restart_node]
+                node.stop(signal.SIGKILL)
+                node.start()
+                trigger_log["node_recovery_s"] = node.wait_ready(
+                    args.ready_timeout)
+            elif trigger_cmd:
+                cmd = cluster.format_command(trigger_cmd)
+                start = time.monotonic()
+                rc = subprocess.run(cmd, shell=True).returncode
+                trigger_log["returncode"] = rc
+                trigger_log["duration_s"] = time.monotonic() - start
+
+        trigger_thread = None
+        if name == "restart" or trigger_cmd:
+            trigger_thread = threading.Thread(target=trigger, daemon=True)
+            trigger_thread.start()
+        if bench.wait() != 0:
+            raise RuntimeError("eloqdb_bench failed in scenario %s" % name)
+        if trigger_thread:
+            trigger_thread.join()
+
+    with open(report_path) as f:
+        report = json.load(f)
+    report["trigger"] = trigger_log
+    return report
+
+
+def compare(baseline, scenario):
+    """Ratio of each latency percentile to the baseline, per engine."""
+    out = {}
+    base = baseline["metrics"]
+    for key, value in scenario["metrics"].items():
+        engine, _, metric = key.partition("_")
+        if not any(metric == p + "_latency_us" for p in PERCENTILES):
+            continue
+        if base.get(key):
+            out["%s_%s_vs_baseline" % (engine, metric[:-len("_latency_us")])] \
+                = value / base[key]
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--eloqdb", required=True, help="eloqdb binary")
+    parser.add_argument("--eloqdb-bench", required=True,
+                        help="eloqdb_bench binary")
+    parser.add_argument("--workdir", default="maintenance_bench_run")
+    parser.add_argument("--nodes", type=int, default=1)
+    parser.add_argument("--base-port", type=int, default=6389)
+    parser.add_argument("--kv-port-offset", type=int, default=0)
+    parser.add_argument("--with-sql", action="store_true")
+    eloqdb_cluster.add_sql_arguments(parser)
+    parser.add_argument("--minio", help="minio binary to run as local S3")
+    parser.add_argument("--s3-endpoint")
+    parser.add_argument("--scenarios", default="checkpoint,eviction",
+                        help="built-in scenarios to compare with the "
+                        "baseline: checkpoint, eviction, restart")
+    parser.add_argument("--trigger", action="append", default=[],
+                        metavar="NAME=CMD")
+    parser.add_argument("--trigger-at", type=float, default=30,
+                        help="seconds into measurement to fire triggers")
+    parser.add_argument("--baseline-checkpoint-interval", type=int,
+                        default=3600)
+    parser.add_argument("--checkpoint-interval", type=int, default=5)
+    parser.add_argument("--eviction-memory-mb", type=int, default=512)
+    parser.add_argument("--records", type=int, default=1000000)
+    parser.add_argument("--ycsb-workload", default="a")
+    parser.add_argument("--kv-threads", type=int, default=16)
+    parser.add_argument("--sql-threads", type=int,
+                        help="SQL clients with --with-sql (default: "
+                        "eloqdb_bench's, 0 if it has no SQL support)")
+    parser.add_argument("--kv-rate", type=float, default=10000)
+    parser.add_argument("--sql-rate", type=float, default=200)
+    parser.add_argument("--warmup", type=float, default=10)
+    parser.add_argument("--duration", type=float, default=120)
+    parser.add_argument("--bench-arg", action="append", default=[],
+                        help="extra eloqdb_bench flag, e.g. "
+                        "--bench-arg=--warehouses=4")
+    parser.add_argument("--ready-timeout", type=float, default=600)
+    parser.add_argument("--output", help="write the JSON report here")
+    args = parser.parse_args()
+
+    scenarios = [s for s in args.scenarios.split(",") if s]
+    for s in scenarios:
+        if s not in ("checkpoint", "eviction", "restart"):
+            parser.error("unknown scenario %r" % s)
+    args.restart_node = None
+    if "restart" in scenarios:
+        if args.nodes < 2:
+            parser.error("the restart scenario needs --nodes >= 2")
+        args.restart_node = args.nodes - 1
+    triggers = {}
+    for item in args.trigger:
+        name, sep, cmd = item.partition("=")
+        if not sep or not name or name in triggers or name == "baseline":
+            parser.error("bad --trigger %r" % item)
+        triggers[name] = cmd
+
+    results = {"baseline": run_scenario(args, "baseline")}
+    for name in scenarios:
+        results[name] = run_scenario(args, name)
+    for name, cmd in triggers.items():
+        results[name] = run_scenario(args, name, trigger_cmd=cmd)
+
+    metrics = {}
+    for name, result in results.items():
+        for key, value in result["metrics"].items():
+            metrics["%s_%s" % (name, key)] = value
+        if name != "baseline":
+            for key, value in compare(results["baseline"], result).items():
+                metrics["%s_%s" % (name, key)] = value
+    report = {
+        "benchmark": "maintenance_bench",
+        "config": {
+            "nodes": args.nodes,
+            "records": args.records,
+            "kv_rate": args.kv_rate,
+            "sql_rate": (args.sql_rate if results["baseline"]["config"].get(
+                "sql_threads") else 0),
+            "duration_s": args.duration,
+            "trigger_at_s": args.trigger_at,
+        },
+        "metrics": metrics,
+        "scenarios": {name: {"trigger": r.get("trigger", {}),
+                             "timeline": r.get("timeline", {})}
+                      for name, r in results.items()},
+    }
+    text = json.dumps(report)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    for name, value in sorted(metrics.items()):
+        if "_vs_baseline" in name or name.startswith("baseline_"):
+            print("%-48s %12.3f" % (name, value), file=sys.stderr)
+    print(text)
+
+
+if __name__ == "__main__":
+    main()
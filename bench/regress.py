@@ -0,0 +1,432 @@
+#!/usr/bin/env python3
+"""Performance regression tracking for eloqdb builds.
+
+Runs benchmark scripts from this directory (or any command that writes the
+common {"metrics": {...}} JSON report) several times against one or two
+eloqdb builds, appends every run to a JSONL history file and compares the
+candidate with a baseline:
+
+  # A/B: run both builds, interleaved to cancel out machine drift
+  regress.py --baseline-eloqdb old/eloqdb --eloqdb new/eloqdb --runs 5
+
+  # record this build, compare with the latest other build in the history
+  regress.py --eloqdb build/eloqdb --label my-change
+
+  # compare two builds already in the history, without running anything
+  regress.py --baseline-label v1.0 --label my-change
+
+For every metric the report gives the mean and confidence interval of each
+build and the relative change. A metric regresses when it moves in the bad
+direction by more than --threshold percent and the Welch t-test confidence
+interval of the difference excludes zero; a metric that was zero in the
+baseline (say, errors) counts as changed by any difference. Changes with
+fewer than two runs on either side cannot be tested and are listed as
+unconfirmed; they do not affect the exit status. Metric names containing
+latency, time, error or abort, or ending in _us/_ms/_s, are
+lower-is-better; all others (throughput) are higher-is-better. The exit
+status is 1 if any metric regressed or any run failed.
+"""
+
+import argparse
+import datetime
+import hashlib
+import json
+import math
+import os
+import re
+import shlex
+import shutil
+import statistics
+import subprocess
+import sys
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+SCRIPTS = {
+    "cluster_harness": "cluster_harness.py",
+    "startup_bench": "startup_bench.py",
+    "maintenance_bench": "maintenance_bench.py",
+}
+LOWER_IS_BETTER = re.compile(
+    r"latency|time|error|abort|recovery|shutdown|_vs_baseline|(_us|_ms|_s)$")
+
+
+# Student's t distribution, via the regularized incomplete beta function
+# (continued fraction from Numerical Recipes).
+def _betacf(a, b, x):
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        for num in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                    -(a + m) * (a + b + m) * x / ((a + 2 * m) *
+                                                 (a + 2 * m + 1))):
+            d = 1.0 + num * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + num / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def _betai(a, b, x):
+    if x <= 0.0 or x >= 1.0:
+        return 0.0 if x <= 0.0 else 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+                     a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * _betacf(a, b, x) / a
+    return 1.0 - front * _betacf(b, a, 1.0 - x) / b
+
+
+def t_cdf(t, df):
+    tail = 0.5 * _betai(df / 2.0, 0.5, df / (df + t * t))
+    return 1.0 - tail if t > 0 else tail
+
+
+def t_ppf(q, df):
+    """Quantile of the t distribution for q in (0.5, 1), by bisection."""
+    lo, hi = 0.0, 1e6
+    for _ in range(200):
+        mid = (lo + hi) / 2.0
+        if t_cdf(mid, df) < q:
+            lo = mid
+        else:
+            hi = mid
+    return (lo + hi) / 2.0
+
+
+def summarize(values, confidence):
+    n = len(values)
+    mean = statistics.mean(values)
+    if n < 2:
+        return {"n": n, "mean": mean, "stdev": None, "ci": None}
+    stdev = statistics.stdev(values)
+    ci = t_ppf((1 + confidence) / 2, n - 1) * stdev / math.sqrt(n)
+    return {"n": n, "mean": mean, "stdev": stdev, "ci": ci}
+
+
+def welch(base, cand, confidence):
+    """Confidence interval and p-value of cand.mean - base.mean."""
+    diff = cand["mean"] - base["mean"]
+    if base["stdev"] is None or cand["stdev"] is None:
+        return diff, None, None
+    vb = base["stdev"] ** 2 / base["n"]
+    vc = cand["stdev"] ** 2 / cand["n"]
+    se = math.sqrt(vb + vc)
+    if se == 0:
+        return diff, 0.0, 1.0 if diff == 0 else 0.0
+    df = (vb + vc) ** 2 / (vb ** 2 / (base["n"] - 1) +
+                           vc ** 2 / (cand["n"] - 1))
+    ci = t_ppf((1 + confidence) / 2, df) * se
+    p = 2 * (1 - t_cdf(abs(diff) / se, df))
+    return diff, ci, p
+
+
+def binary_label(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            digest.update(chunk)
+    return "build-" + digest.hexdigest()[:12]
+
+
+def benchmark_command(args, name, eloqdb, workdir, output):
+    extra = args.bench_args.get(name, "")
+    if name in args.commands:
+        return args.commands[name].format(
+            eloqdb=shlex.quote(eloqdb), workdir=shlex.quote(workdir),
+            output=shlex.quote(output)) + (" " + extra if extra else "")
+    cmd = [sys.executable, os.path.join(BENCH_DIR, SCRIPTS[name]),
+           "--eloqdb", eloqdb, "--workdir", workdir, "--output", output]
+    if args.with_sql:
+        cmd.append("--with-sql")
+    if name == "maintenance_bench":
+        cmd += ["--eloqdb-bench", args.eloqdb_bench]
+    return " ".join(shlex.quote(c) for c in cmd + shlex.split(extra))
+
+
+def run_benchmark(args, name, label, eloqdb, run):
+    run_dir = os.path.join(args.workdir, label, "%s.%d" % (name, run))
+    output = run_dir + ".json"
+    log_path = run_dir + ".log"
+    os.makedirs(os.path.dirname(run_dir), exist_ok=True)
+    entry = {
+        "time": datetime.datetime.now().isoformat(timespec="seconds"),
+        "label": label,
+        "eloqdb": os.path.abspath(eloqdb),
+        "benchmark": name,
+        "args": args.bench_args.get(name, ""),
+        "run": run,
+    }
+    cmd = benchmark_command(args, name, eloqdb, run_dir, output)
+    print("[%s] %s run %d" % (label, name, run), file=sys.stderr)
+    with open(log_path, "w") as log:
+        rc = subprocess.run(cmd, shell=True, stdout=subprocess.DEVNULL,
+                            stderr=log).returncode
+    try:
+        if rc != 0:
+            raise RuntimeError("exit status %d, see %s" % (rc, log_path))
+        with open(output) as f:
+            report = json.load(f)
+        entry["config"] = report.get("config", {})
+        entry["metrics"] = report["metrics"]
+    except (OSError, ValueError, KeyError, RuntimeError) as e:
+        entry["error"] = str(e)
+        print("[%s] %s run %d failed: %s" % (label, name, run, e),
+              file=sys.stderr)
+    if not args.keep_workdirs:
+        shutil.rmtree(run_dir, ignore_errors=True)
+    with open(args.history, "a") as f:
+        f.write(json.dumps(entry, sort_keys=True) + "\n")
+    return entry
+
+
+def load_history(path):
+    entries = []
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                if line.strip():
+                    entries.append(json.loads(line))
+    return entries
+
+
+def latest_other_label(history, label, benchmarks):
+    for entry in reversed(history):
+        if (entry["label"] != label and entry["benchmark"] in benchmarks and
+                "metrics" in entry):
+            return entry["label"]
+    return None
+
+
+def compare(args, history, base_label, cand_label, benchmarks):
+    ignore = re.compile(args.ignore) if args.ignore else None
+    rows = []
+    for bench in benchmarks:
+        cand = [e for e in history if e["label"] == cand_label and
+                e["benchmark"] == bench and "metrics" in e]
+        if not cand:
+            print("no successful %s runs of %s in the history" %
+                  (bench, cand_label), file=sys.stderr)
+            continue
+        # Only runs with the same benchmark arguments are comparable.
+        bench_args = cand[-1]["args"]
+        cand = [e for e in cand if e["args"] == bench_args]
+        base = [e for e in history if e["label"] == base_label and
+                e["benchmark"] == bench and "metrics" in e and
+                e["args"] == bench_args]
+        if not base:
+            print("no %s runs of %s with args %r in the history" %
+                  (bench, base_label, bench_args), file=sys.stderr)
+            continue
+        names = sorted(set(cand[-1]["metrics"]) &
+                       set(n for e in base for n in e["metrics"]))
+        for metric in names:
+            if ignore and ignore.search(metric):
+                continue
+            bv = [e["metrics"][metric] for e in base if metric in e["metrics"]]
+            cv = [e["metrics"][metric] for e in cand if metric in e["metrics"]]
+            b = summarize(bv, args.confidence)
+            c = summarize(cv, args.confidence)
+            diff, diff_ci, p = welch(b, c, args.confidence)
+            lower_better = bool(LOWER_IS_BETTER.search(metric))
+            # A change from a zero baseline (e.g. 0 -> N errors) has no
+            # percentage; any difference passes the threshold and is left
+            # to the significance test.
+            change = diff / abs(b["mean"]) * 100 if b["mean"] else None
+            worse = diff > 0 if lower_better else diff < 0
+            verdict = "same"
+            if (abs(change) >= args.threshold if change is not None
+                    else diff != 0):
+                verdict = "regression" if worse else "improvement"
+                # With fewer than two runs on either side there is no
+                # interval to test; report the change without acting on it.
+                if diff_ci is None:
+                    verdict = "unconfirmed " + verdict
+                elif abs(diff) <= diff_ci:
+                    verdict = "same"
+            rows.append({
+                "benchmark": bench,
+                "metric": metric,
+                "lower_is_better": lower_better,
+                "baseline": b,
+                "candidate": c,
+                "change_pct": change,
+                "diff_ci": diff_ci,
+                "p_value": p,
+                "verdict": verdict,
+            })
+    return rows
+
+
+def format_mean(s):
+    if s["ci"] is None:
+        return "%.4g (n=%d)" % (s["mean"], s["n"])
+    return "%.4g ±%.2g" % (s["mean"], s["ci"])
+
+
+def print_rows(rows, verbose):
+    print("%-18s %-40s %18s %18s %9s  %s" % (
+        "benchmark", "metric", "baseline", "candidate", "change",
+        "verdict"), file=sys.stderr)
+    for r in rows:
+        if r["verdict"] == "same" and not verbose:
+            continue
+        if r["change_pct"] is not None:
+            change = "%+.1f%%" % r["change_pct"]
+        else:
+            change = "from 0" if r["candidate"]["mean"] else "-"
+        verdict = r["verdict"].upper() if r["verdict"] == "regression" \
+            else r["verdict"]
+        if r["verdict"].startswith("unconfirmed"):
+            verdict += " (n<2)"
+        print("%-18s %-40s %18s %18s %9s  %s" % (
+            r["benchmark"], r["metric"], format_mean(r["baseline"]),
+            format_mean(r["candidate"]), change, verdict), file=sys.stderr)
+
+
+def parse_pairs(parser, items, option):
+    pairs = {}
+    for item in items:
+        name, sep, value = item.partition("=")
+        if not sep or not name:
+            parser.error("bad %s %r, expected NAME=VALUE" % (option, item))
+        pairs[name] = value
+    return pairs
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--eloqdb", help="candidate eloqdb binary to run")
+    parser.add_argument("--label",
+                        help="candidate label (default: binary hash)")
+    parser.add_argument("--baseline-eloqdb",
+                        help="baseline eloqdb binary to run alongside")
+    parser.add_argument("--baseline-label",
+                        help="baseline label (default: binary hash, or the "
+                        "latest other label in the history)")
+    parser.add_argument("--benchmarks", default="cluster_harness,startup_bench",
+                        help="comma-separated: %s, or names defined with "
+                        "--command" % ", ".join(sorted(SCRIPTS)))
+    parser.add_argument("--bench-args", action="append", default=[],
+                        metavar="NAME=ARGS",
+                        help="extra arguments for one benchmark, e.g. "
+                        "startup_bench=\"--records 100000\"")
+    parser.add_argument("--command", action="append", default=[],
+                        metavar="NAME=CMD",
+                        help="custom benchmark; {eloqdb}, {workdir} and "
+                        "{output} are substituted and CMD must write a "
+                        "metrics JSON report to {output}")
+    parser.add_argument("--eloqdb-bench", help="eloqdb_bench binary, needed "
+                        "by maintenance_bench")
+    parser.add_argument("--with-sql", action="store_true")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--workdir", default="regress_run")
+    parser.add_argument("--history",
+                        help="JSONL history (default: WORKDIR/history.jsonl)")
+    parser.add_argument("--keep-workdirs", action="store_true")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="minimum change in percent to flag")
+    parser.add_argument("--confidence", type=float, default=0.95)
+    parser.add_argument("--ignore", help="regex of metric names to skip")
+    parser.add_argument("--verbose", action="store_true",
+                        help="also print unchanged metrics")
+    parser.add_argument("--output", help="write the JSON report here")
+    args = parser.parse_args()
+
+    args.bench_args = parse_pairs(parser, args.bench_args, "--bench-args")
+    args.commands = parse_pairs(parser, args.command, "--command")
+    benchmarks = [b for b in args.benchmarks.split(",") if b]
+    for bench in benchmarks:
+        if bench not in SCRIPTS and bench not in args.commands:
+            parser.error("unknown benchmark %r" % bench)
+    if "maintenance_bench" in benchmarks and not args.eloqdb_bench:
+        parser.error("maintenance_bench needs --eloqdb-bench")
+    if args.baseline_eloqdb and not args.eloqdb:
+        parser.error("--baseline-eloqdb needs --eloqdb")
+    if not args.eloqdb and not (args.label and args.baseline_label):
+        parser.error("give --eloqdb, or --label and --baseline-label to "
+                     "compare stored results")
+    if not 0 < args.confidence < 1:
+        parser.error("--confidence must be in (0, 1)")
+    os.makedirs(args.workdir, exist_ok=True)
+    args.history = args.history or os.path.join(args.workdir, "history.jsonl")
+
+    builds = []
+    if args.eloqdb:
+        args.label = args.label or binary_label(args.eloqdb)
+        builds.append((args.label, args.eloqdb))
+    if args.baseline_eloqdb:
+        args.baseline_label = (args.baseline_label or
+                               binary_label(args.baseline_eloqdb))
+        if args.baseline_label == args.label:
+            parser.error("baseline and candidate have the same label")
+        builds.insert(0, (args.baseline_label, args.baseline_eloqdb))
+
+    failures = 0
+    for run in range(args.runs if builds else 0):
+        # Alternate the build order so slow drift (thermal, page cache,
+        # background jobs) does not consistently favour one build.
+        order = builds if run % 2 == 0 else builds[::-1]
+        for bench in benchmarks:
+            for label, eloqdb in order:
+                if "error" in run_benchmark(args, bench, label, eloqdb, run):
+                    failures += 1
+
+    history = load_history(args.history)
+    if not args.baseline_label:
+        args.baseline_label = latest_other_label(history, args.label,
+                                                 benchmarks)
+        if not args.baseline_label:
+            print("recorded %s in %s; no other build to compare with" %
+                  (args.label, args.history), file=sys.stderr)
+            return 1 if failures else 0
+
+    rows = compare(args, history, args.baseline_label, args.label,
+                   benchmarks)
+    regressions = [r for r in rows if r["verdict"] == "regression"]
+    unconfirmed = [r for r in rows if r["verdict"].startswith("unconfirmed")]
+    print("baseline %s vs candidate %s, %d%% confidence, threshold %g%%" % (
+        args.baseline_label, args.label, args.confidence * 100,
+        args.threshold), file=sys.stderr)
+    print_rows(rows, args.verbose)
+    print("%d regression(s), %d improvement(s), %d unconfirmed change(s), "
+          "%d failed run(s)" % (
+              len(regressions),
+              sum(1 for r in rows if r["verdict"] == "improvement"),
+              len(unconfirmed), failures), file=sys.stderr)
+
+    report = {
+        "benchmark": "regress",
+        "config": {
+            "baseline": args.baseline_label,
+            "candidate": args.label,
+            "benchmarks": benchmarks,
+            "runs": args.runs if builds else 0,
+            "threshold_pct": args.threshold,
+            "confidence": args.confidence,
+        },
+        "failed_runs": failures,
+        "regressions": [{"benchmark": r["benchmark"], "metric": r["metric"],
+                         "change_pct": r["change_pct"]}
+                        for r in regressions],
+        "unconfirmed": [{"benchmark": r["benchmark"], "metric": r["metric"],
+                         "change_pct": r["change_pct"],
+                         "verdict": r["verdict"]}
+                        for r in unconfirmed],
+        "comparisons": rows,
+    }
+    text = json.dumps(report)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    print(text)
+    return 1 if regressions or failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
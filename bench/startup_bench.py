@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""Startup and recovery time benchmark for eloqdb.
+
+Loads a dataset into a local cluster (see eloqdb_cluster.py), then
+repeatedly stops one node (clean SIGTERM shutdown and SIGKILL crash),
+restarts it and records:
+  - shutdown time (SIGTERM until exit)
+  - every "Startup phase <name> took <ms> ms" line printed by main()
+    (data_substrate_init, eloqkv_init, engine_registration,
+    data_substrate_start, eloqkv_start, eloqkv_listen, total)
+  - time from exec to the first successful KV request and, with
+    --with-sql, to the first MySQL server greeting
+  - time until read latency over random loaded keys is back within
+    --warm-tolerance of its pre-restart value (cache warm-up)
+
+Results are averaged per restart mode and written as JSON in the same
+"metrics" layout as eloqdb_bench.
+"""
+
+import argparse
+import json
+import random
+import signal
+import socket
+import statistics
+import subprocess
+import sys
+import time
+
+import eloqdb_cluster
+
+PHASE_PREFIX = "Startup phase "
+
+
+def kv_key(keynum):
+    """Key of record `keynum`, matching eloqdb_bench's KvKey()."""
+    value = keynum
+    h = 0xcbf29ce484222325
+    for _ in range(8):
+        h ^= value & 0xff
+        h = (h * 0x100000001b3) & 0xffffffffffffffff
+        value >>= 8
+    return b"user%d" % h
+
+
+def load_kv(node, records, value_size, batch=500):
+    conn = eloqdb_cluster.RespConnection(node.host, node.kv_port, timeout=60)
+    value = b"v" * value_size
+    try:
+        for first in range(0, records, batch):
+            conn.pipeline([(b"HSET", kv_key(k), b"field0", value)
+                           for k in range(first, min(records, first + batch))])
+    finally:
+        conn.close()
+
+
+def read_round(node, records, samples, rand):
+    """Median latency (us) of `samples` single reads of random records."""
+    conn = eloqdb_cluster.RespConnection(node.host, node.kv_port)
+    latencies = []
+    try:
+        for _ in range(samples):
+            key = kv_key(rand.randrange(records))
+            start = time.perf_counter()
+            conn.pipeline([(b"HGETALL", key)])
+            latencies.append((time.perf_counter() - start) * 1e6)
+    finally:
+        conn.close()
+    return statistics.median(latencies)
+
+
+def wait_for_sql_greeting(host, port, timeout):
+    """Seconds until the MySQL listener sends its handshake packet."""
+    start = time.monotonic()
+    while time.monotonic() - start < timeout:
+        try:
+            with socket.create_connection((host, port), timeout=1.0) as sock:
+                if sock.recv(4):
+                    return time.monotonic() - start
+        except OSError:
+            pass
+        time.sleep(0.05)
+    return None
+
+
+def parse_phases(log_path, offset):
+    phases = {}
+    with open(log_path, "rb") as f:
+        f.seek(offset)
+        for line in f.read().decode(errors="replace").splitlines():
+            if not line.startswith(PHASE_PREFIX):
+                continue
+            name, _, rest = line[len(PHASE_PREFIX):].partition(" took ")
+            try:
+                phases[name] = float(rest.split()[0])
+            except (IndexError, ValueError):
+                pass
+    return phases
+
+
+def restart_once(args, node, sig, baseline_us, rand):
+    result = {}
+    stop_start = time.monotonic()
+    node.stop(sig, timeout=args.ready_timeout)
+    result["shutdown_s"] = time.monotonic() - stop_start
+
+    offset = 0
+    try:
+        with open(node.log_path, "rb") as f:
+            offset = f.seek(0, 2)
+    except OSError:
+        pass
+    node.start()
+    first_kv = node.wait_ready(args.ready_timeout)
+    if first_kv is None:
+        raise RuntimeError("node did not come back, see %s" % node.log_path)
+    result["first_kv_request_s"] = first_kv
+    if args.with_sql:
+        # Measured from when KV answered; add it to get time since exec.
+        greeting = wait_for_sql_greeting(node.host, node.sql_port,
+                                         args.ready_timeout)
+        if greeting is not None:
+            result["first_sql_connect_s"] = first_kv + greeting
+
+    warm_start = time.monotonic()
+    while time.monotonic() - warm_start < args.warm_timeout:
+        median = read_round(node, args.records, args.warm_sample, rand)
+        if median <= baseline_us * (1 + args.warm_tolerance):
+            result["warm_cache_s"] = (first_kv +
+                                      time.monotonic() - warm_start)
+            break
+    for name, ms in parse_phases(node.log_path, offset).items():
+        result["phase_%s_ms" % name] = ms
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--eloqdb", required=True, help="eloqdb binary")
+    parser.add_argument("--workdir", default="startup_bench_run")
+    parser.add_argument("--nodes", type=int, default=1)
+    parser.add_argument("--node", type=int, default=0,
+                        help="index of the node that is restarted")
+    parser.add_argument("--base-port", type=int, default=6389)
+    parser.add_argument("--kv-port-offset", type=int, default=0)
+    parser.add_argument("--with-sql", action="store_true")
+    eloqdb_cluster.add_sql_arguments(parser)
+    parser.add_argument("--minio", help="minio binary to run as local S3")
+    parser.add_argument("--s3-endpoint")
+    parser.add_argument("--records", type=int, default=1000000)
+    parser.add_argument("--value-size", type=int, default=100)
+    parser.add_argument("--load-cmd",
+                        help="load with this command instead of the built-in "
+                        "KV loader, e.g. \"eloqdb_bench --load --run=false "
+                        "--kv_endpoints={kv_endpoints} "
+                        "--sql_endpoints={sql_endpoints}\"; records it "
+                        "writes must use eloqdb_bench's key scheme")
+    parser.add_argument("--modes", default="clean,crash",
+                        help="restart modes: clean (SIGTERM), crash (SIGKILL)")
+    parser.add_argument("--iterations", type=int, default=3)
+    parser.add_argument("--warm-sample", type=int, default=2000,
+                        help="reads per warm-up probe round")
+    parser.add_argument("--warm-tolerance", type=float, default=0.1)
+    parser.add_argument("--warm-timeout", type=float, default=600)
+    parser.add_argument("--ready-timeout", type=float, default=600)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--output", help="write the JSON report here")
+    args = parser.parse_args()
+
+    signals = {"clean": signal.SIGTERM, "crash": signal.SIGKILL}
+    modes = [m for m in args.modes.split(",") if m]
+    for mode in modes:
+        if mode not in signals:
+            parser.error("unknown restart mode %r" % mode)
+
+    rand = random.Random(args.seed)
+    cluster = eloqdb_cluster.Cluster(
+        args.eloqdb, args.workdir, nodes=args.nodes, base_port=args.base_port,
+        kv_port_offset=args.kv_port_offset, with_sql=args.with_sql,
+        s3_endpoint=args.s3_endpoint, minio=args.minio,
+        sql_overrides=eloqdb_cluster.parse_overrides(args.sql_set, "mariadb"),
+        sql_install_db=args.sql_install_db)
+    runs = {mode: [] for mode in modes}
+    with cluster:
+        cluster.start(ready_timeout=args.ready_timeout)
+        node = cluster.nodes[args.node]
+
+        load_start = time.monotonic()
+        if args.load_cmd:
+            subprocess.run(cluster.format_command(args.load_cmd),
+                           shell=True, check=True)
+        else:
+            load_kv(node, args.records, args.value_size)
+        load_s = time.monotonic() - load_start
+        print("loaded %d records in %.1fs" % (args.records, load_s),
+              file=sys.stderr)
+
+        for mode in modes:
+            for i in range(args.iterations):
+                # Re-measure the warm baseline before every restart so
+                # drift between iterations does not skew warm-up times.
+                read_round(node, args.records, args.warm_sample, rand)
+                baseline = read_round(node, args.records, args.warm_sample,
+                                      rand)
+                result = restart_once(args, node, signals[mode], baseline,
+                                      rand)
+                result["baseline_read_us"] = baseline
+                runs[mode].append(result)
+                print("%s restart %d: %s" % (mode, i, json.dumps(result)),
+                      file=sys.stderr)
+
+    metrics = {"load_s": load_s}
+    for mode, results in runs.items():
+        keys = sorted({k for r in results for k in r})
+        for key in keys:
+            values = [r[key] for r in results if key in r]
+            metrics["%s_%s" % (mode, key)] = statistics.mean(values)
+    report = {
+        "benchmark": "startup_bench",
+        "config": {
+            "nodes": args.nodes,
+            "records": args.records,
+            "value_size": args.value_size,
+            "iterations": args.iterations,
+        },
+        "metrics": metrics,
+        "runs": runs,
+    }
+    text = json.dumps(report)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    for name, value in sorted(metrics.items()):
+        print("%-40s %12.3f" % (name, value), file=sys.stderr)
+    print(text)
+
+
+if __name__ == "__main__":
+    main()
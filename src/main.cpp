@@ -11,14 +11,22 @@
  * 7. Start EloqKV server
  */
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cerrno>
 #include <csignal>
+#include <cstdlib>
+#include <fstream>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <sched.h>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "data_substrate.h"
 
@@ -35,6 +43,11 @@ DEFINE_string(eloqkv_config, "",
               "Path to EloqKV configuration file (optional)");
 DEFINE_string(eloqsql_config, "",
               "Path to EloqSQL configuration file (optional)");
+DEFINE_int32(eloqsql_thread_pool_size, 0,
+             "Number of EloqSQL thread pool groups. 0 derives it from the "
+             "cores not reserved for EloqKV (core_number) unless the EloqSQL "
+             "configuration sets thread_pool_size, a negative value always "
+             "keeps the configured value");
 
 constexpr char VERSION[] = "1.0.0";
 
@@ -58,10 +71,164 @@ extern brpc::Acceptor *EloqKV::server_acceptor;
 
 #ifdef ELOQ_MODULE_ELOQSQL
 std::thread g_eloqsql_thread;
+// mysqld keeps pointers into its argv, so the extended argument list must
+// outlive the EloqSQL thread.
+std::vector<std::string> g_eloqsql_extra_args;
+std::vector<char *> g_eloqsql_argv;
 extern int mysqld_main(int argc, char **argv);
 extern void shutdown_mysqld();
+
+// Looks up `key` in any of `sections` of an ini-style config file. Dashes
+// and underscores in option names are equivalent, as in MariaDB option
+// files. Returns false if the file cannot be read or does not set the key.
+bool ReadConfigValue(const std::string &path,
+                     const std::vector<std::string> &sections,
+                     const std::string &key, std::string *value) {
+  auto normalize = [](std::string name) {
+    std::replace(name.begin(), name.end(), '-', '_');
+    return name;
+  };
+  const std::string wanted = normalize(key);
+  std::ifstream in(path);
+  std::string line;
+  bool in_section = false;
+  while (std::getline(in, line)) {
+    size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#' ||
+        line[first] == ';') {
+      continue;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    line = line.substr(first, last - first + 1);
+    if (line.front() == '[') {
+      in_section = std::find(sections.begin(), sections.end(), line) !=
+                   sections.end();
+      continue;
+    }
+    size_t eq = line.find('=');
+    if (!in_section || eq == std::string::npos) {
+      continue;
+    }
+    std::string name = line.substr(0, line.find_last_not_of(" \t", eq - 1) + 1);
+    if (normalize(name) == wanted) {
+      size_t start = line.find_first_not_of(" \t", eq + 1);
+      *value = start == std::string::npos ? "" : line.substr(start);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Parses a non-negative integer core count, rejecting trailing garbage.
+bool ParseCoreCount(const std::string &text, int *cores) {
+  char *end = nullptr;
+  errno = 0;
+  long v = std::strtol(text.c_str(), &end, 10);
+  if (end == text.c_str() || *end != '\0' || errno == ERANGE || v < 0 ||
+      v > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  *cores = static_cast<int>(v);
+  return true;
+}
+
+// Cores this process may run on: the CPU affinity mask (taskset, cpuset
+// cgroups), further capped by a cgroup v2 CPU quota (cpu.max).
+int AvailableCores() {
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    cores = CPU_COUNT(&set);
+  }
+  std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+  std::string quota;
+  long period = 0;
+  if (cpu_max >> quota >> period && quota != "max" && period > 0) {
+    long quota_us = std::strtol(quota.c_str(), nullptr, 10);
+    if (quota_us > 0) {
+      int quota_cores =
+          static_cast<int>(std::max(1L, (quota_us + period - 1) / period));
+      cores = cores > 0 ? std::min(cores, quota_cores) : quota_cores;
+    }
+  }
+  return cores;
+}
+
+// Returns the thread pool group count to pass to mysqld, or 0 to leave the
+// configured value alone. Thread pool groups map to cores, so in the
+// converged binary they are sized from what EloqKV's workers leave free,
+// unless the operator set thread_pool_size in the EloqSQL config.
+int EloqSqlThreadPoolSize() {
+  if (FLAGS_eloqsql_thread_pool_size < 0) {
+    return 0;
+  }
+  if (FLAGS_eloqsql_thread_pool_size > 0) {
+    return FLAGS_eloqsql_thread_pool_size;
+  }
+  const std::string &sql_config =
+      FLAGS_eloqsql_config.empty() ? FLAGS_config : FLAGS_eloqsql_config;
+  std::string configured;
+  if (ReadConfigValue(sql_config,
+                      {"[mysqld]", "[server]", "[mariadb]", "[mariadbd]"},
+                      "thread_pool_size", &configured)) {
+    LOG(INFO) << "Keeping thread_pool_size=" << configured << " from "
+              << sql_config;
+    return 0;
+  }
+
+  int total_cores = AvailableCores();
+  if (total_cores <= 0) {
+    return 0;
+  }
+  int kv_cores = 0;
+#ifdef ELOQ_MODULE_ELOQKV
+  // Resolve core_number the way EloqKV does: an explicit --core_number
+  // overrides [local] core_number in its config file, which overrides the
+  // flag default. This runs before EloqKV's Init, so read the file here.
+  std::string core_number;
+  GFLAGS_NAMESPACE::CommandLineFlagInfo info;
+  if (GFLAGS_NAMESPACE::GetCommandLineFlagInfo("core_number", &info) &&
+      !info.is_default) {
+    core_number = info.current_value;
+  } else {
+    const std::string &config =
+        FLAGS_eloqkv_config.empty() ? FLAGS_config : FLAGS_eloqkv_config;
+    if (!ReadConfigValue(config, {"[local]"}, "core_number", &core_number)) {
+      core_number = info.current_value;
+    }
+  }
+  if (!core_number.empty() && !ParseCoreCount(core_number, &kv_cores)) {
+    LOG(WARNING) << "Ignoring invalid core_number '" << core_number
+                 << "', keeping the configured EloqSQL thread_pool_size";
+    return 0;
+  }
+#endif
+  return std::max(1, total_cores - kv_cores);
+}
 #endif
 
+// Startup phase timing. Each phase's duration is logged and printed as
+// "Startup phase <name> took <ms> ms" so restart time can be measured per
+// phase (see bench/startup_bench.py).
+std::chrono::steady_clock::time_point g_startup_begin;
+std::chrono::steady_clock::time_point g_phase_begin;
+
+void LogStartupPhase(const char *phase,
+                     std::chrono::steady_clock::time_point begin,
+                     std::chrono::steady_clock::time_point end) {
+  double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+  LOG(INFO) << "Startup phase " << phase << " took " << ms << " ms";
+  std::cout << "Startup phase " << phase << " took " << ms << " ms"
+            << std::endl;
+}
+
+void EndStartupPhase(const char *phase) {
+  auto now = std::chrono::steady_clock::now();
+  LogStartupPhase(phase, g_phase_begin, now);
+  g_phase_begin = now;
+}
+
 // Forward declaration
 void CleanupComponents();
 
@@ -125,6 +292,7 @@ void CleanupComponents() {
 }
 
 int main(int argc, char *argv[]) {
+  g_startup_begin = g_phase_begin = std::chrono::steady_clock::now();
   google::SetVersionString(VERSION);
   google::ParseCommandLineFlags(&argc, &argv, true);
 #if BRPC_WITH_GLOG
@@ -151,6 +319,7 @@ int main(int argc, char *argv[]) {
   g_init_state.data_substrate_init = true;
   LOG(INFO) << "Data substrate initialized (config loaded)";
   std::cout << "Data substrate initialized" << std::endl;
+  EndStartupPhase("data_substrate_init");
 
   auto &ds = DataSubstrate::Instance();
 
@@ -165,10 +334,23 @@ int main(int argc, char *argv[]) {
   ds.EnableEngine(txservice::TableEngine::EloqSql);
 
   std::cout << "Starting EloqSQL initialization..." << std::endl;
+
+  g_eloqsql_argv.assign(argv, argv + argc);
+  if (int pool_size = EloqSqlThreadPoolSize(); pool_size > 0) {
+    LOG(INFO) << "Sizing EloqSQL thread pool to " << pool_size << " groups";
+    g_eloqsql_extra_args.push_back("--thread-pool-size=" +
+                                   std::to_string(pool_size));
+  }
+  for (std::string &arg : g_eloqsql_extra_args) {
+    g_eloqsql_argv.push_back(arg.data());
+  }
+  g_eloqsql_argv.push_back(nullptr);
+
   LOG(INFO) << "Launching EloqSQL main thread";
 
-  g_eloqsql_thread = std::thread([argc, argv]() {
-    int result = mysqld_main(argc, argv);
+  g_eloqsql_thread = std::thread([]() {
+    int result = mysqld_main(static_cast<int>(g_eloqsql_argv.size()) - 1,
+                             g_eloqsql_argv.data());
     if (result != 0) {
       LOG(ERROR) << "EloqSQL server exited with error: " << result;
     }
@@ -206,6 +388,7 @@ int main(int argc, char *argv[]) {
   }
   g_init_state.eloqkv_init = true;
   g_init_state.eloqkv_service_ptr = eloqkv_service_ptr;
+  EndStartupPhase("eloqkv_init");
 #endif
 
 #ifdef ELOQ_MODULE_ELOQDOC
@@ -225,6 +408,7 @@ int main(int argc, char *argv[]) {
     goto cleanup;
   }
   LOG(INFO) << "All enabled engines registered successfully";
+  EndStartupPhase("engine_registration");
 
   // Step 4: Start DataSubstrate and notify engines
   std::cout << "Starting data substrate services..." << std::endl;
@@ -235,6 +419,7 @@ int main(int argc, char *argv[]) {
   }
   LOG(INFO) << "Data substrate started successfully";
   std::cout << "Data substrate started" << std::endl;
+  EndStartupPhase("data_substrate_start");
 
   // Step 5 (engine side, not shown here):
   // - Engines call WaitForDataSubstrateStarted() before entering serve loop
@@ -247,6 +432,7 @@ int main(int argc, char *argv[]) {
     return_code = -1;
     goto cleanup;
   }
+  EndStartupPhase("eloqkv_start");
 
   // Start EloqKV server (after data substrate is initialized)
   // Track pointer before release (release transfers ownership to brpc)
@@ -267,10 +453,12 @@ int main(int argc, char *argv[]) {
   std::cout << "EloqKV server listening on " << EloqKV::redis_ip_port
             << std::endl;
   EloqKV::server_acceptor = g_eloqkv_server->GetAcceptor();
+  EndStartupPhase("eloqkv_listen");
 #endif
 
   std::cout << "======================================" << std::endl;
   std::cout << "All servers started successfully" << std::endl;
+  LogStartupPhase("total", g_startup_begin, std::chrono::steady_clock::now());
   std::cout << "Press Ctrl+C to shutdown" << std::endl;
   std::cout << "======================================" << std::endl;
 